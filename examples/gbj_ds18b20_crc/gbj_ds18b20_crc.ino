@@ -0,0 +1,105 @@
+/*
+  NAME:
+  Microbenchmark of CRC8 validation of scratchpads.
+
+  DESCRIPTION:
+  The sketch compares time of validating a batch of scratchpads by the bit-wise
+  checksum of the library OneWire per frame, by the table driven checksum per
+  frame, and by the batch validation of the library.
+  - The sketch does not need any sensor on the one-wire bus.
+  - Every other scratchpad in the batch is corrupted, so that all methods
+    should report the same number of valid frames.
+
+  LICENSE:
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the MIT License (MIT).
+
+  CREDENTIALS:
+  Author: Libor Gabaj
+*/
+#include "gbj_ds18b20.h"
+
+#define SKETCH "GBJ_DS18B20_CRC 1.0.0"
+
+const unsigned long SERIAL_DEBUG_BAUD = 9600;
+const unsigned int PERIOD_LOOP = 5000; // Milliseconds at the end of the loop
+const unsigned int FRAMES = 32; // Scratchpads in the batch
+const unsigned int ROUNDS = 100; // Repetitions of validating the batch
+
+gbj_ds18b20::Scratchpad frames[FRAMES];
+
+void prepare()
+{
+  for (unsigned int i = 0; i < FRAMES; i++)
+  {
+    for (byte j = 0; j < gbj_ds18b20::SCRATCHPAD_LEN - 1; j++)
+    {
+      frames[i][j] = random(256);
+    }
+    frames[i][gbj_ds18b20::SCRATCHPAD_LEN - 1] =
+      OneWire::crc8(frames[i], gbj_ds18b20::SCRATCHPAD_LEN - 1);
+    if (i % 2)
+    {
+      frames[i][0] ^= 0x01;
+    }
+  }
+}
+
+void report(const char *method, unsigned long tsStart, unsigned int valid)
+{
+  unsigned long duration = micros() - tsStart;
+  Serial.println(String(method) + ": " + String(valid / ROUNDS) + " valid, " +
+                 String((float)duration / (ROUNDS * FRAMES), 2) +
+                 " us/frame");
+}
+
+void setup()
+{
+  Serial.begin(SERIAL_DEBUG_BAUD);
+  Serial.println();
+  Serial.println(SKETCH);
+  Serial.println("Frames: " + String(FRAMES));
+  Serial.println("---");
+  prepare();
+}
+
+void loop()
+{
+  unsigned long tsStart;
+  unsigned int valid;
+
+  valid = 0;
+  tsStart = micros();
+  for (unsigned int r = 0; r < ROUNDS; r++)
+  {
+    for (unsigned int i = 0; i < FRAMES; i++)
+    {
+      valid += frames[i][gbj_ds18b20::SCRATCHPAD_LEN - 1] ==
+               OneWire::crc8(frames[i], gbj_ds18b20::SCRATCHPAD_LEN - 1);
+    }
+  }
+  report("OneWire", tsStart, valid);
+
+  valid = 0;
+  tsStart = micros();
+  for (unsigned int r = 0; r < ROUNDS; r++)
+  {
+    for (unsigned int i = 0; i < FRAMES; i++)
+    {
+      valid += gbj_ds18b20_crc::isValid(frames[i], gbj_ds18b20::SCRATCHPAD_LEN);
+    }
+  }
+  report("Table", tsStart, valid);
+
+  valid = 0;
+  tsStart = micros();
+  for (unsigned int r = 0; r < ROUNDS; r++)
+  {
+    valid += gbj_ds18b20_crc::validate(
+      frames[0], gbj_ds18b20::SCRATCHPAD_LEN, FRAMES);
+  }
+  report("Batch", tsStart, valid);
+
+  Serial.println("---");
+  delay(PERIOD_LOOP);
+}
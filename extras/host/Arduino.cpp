@@ -0,0 +1,3 @@
+#include "Arduino.h"
+
+uint32_t hostMicros = 0;
@@ -0,0 +1,40 @@
+/*
+  NAME:
+  Arduino core shim for running the library on a host.
+
+  DESCRIPTION:
+  The shim provides just the part of the Arduino core used by the library.
+  - Time is virtual. It is advanced by delays, by the simulated one-wire bus,
+    or set by a replayed trace, so that runs are deterministic.
+
+  LICENSE:
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the MIT License (MIT).
+
+  CREDENTIALS:
+  Author: Libor Gabaj
+*/
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <algorithm>
+#include <stdint.h>
+#include <string.h>
+
+typedef uint8_t byte;
+
+#define constrain(amt, low, high)                                              \
+  ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+using std::max;
+using std::min;
+
+// Virtual time in microseconds
+extern uint32_t hostMicros;
+
+inline unsigned long micros() { return hostMicros; }
+inline unsigned long millis() { return hostMicros / 1000; }
+inline void delay(unsigned long ms) { hostMicros += ms * 1000; }
+inline void delayMicroseconds(unsigned int us) { hostMicros += us; }
+inline void yield() {}
+
+#endif
@@ -0,0 +1,299 @@
+#include "OneWire.h"
+#include <vector>
+
+uint32_t OneWireSim::resets_ = 0;
+uint32_t OneWireSim::slots_ = 0;
+uint32_t OneWireSim::conversions_ = 0;
+void (*OneWireSim::resetHook_)() = 0;
+
+namespace
+{
+enum Commands : uint8_t
+{
+  CONVERT_T = 0x44,
+  WRITE_SCRATCHPAD = 0x4E,
+  READ_SCRATCHPAD = 0xBE,
+  COPY_SCRATCHPAD = 0x48,
+  RECALL = 0xB8,
+  READ_POWER_SUPPLY = 0xB4,
+};
+
+enum States : uint8_t
+{
+  STATE_ROM,
+  STATE_FUNCTION,
+  STATE_WRITE,
+  STATE_READ,
+  STATE_POWER,
+};
+
+struct Sensor
+{
+  uint8_t rom[8];
+  uint8_t scratchpad[9];
+  uint8_t eeprom[3];
+  int16_t temperature;
+  uint32_t tsConvEnd;
+  bool converting;
+};
+
+// Maximal conversion times in microseconds
+const uint32_t convMicros[4] = { 93750, 187500, 375000, 750000 };
+
+std::vector<Sensor> sensors;
+bool parasite;
+uint8_t convPercent;
+States state = STATE_ROM;
+// Index of selected sensor, all sensors by negative value
+int selected = -1;
+uint8_t position;
+size_t searchIndex;
+
+uint8_t crc(const uint8_t *data, uint8_t len)
+{
+  return OneWire::crc8(data, len);
+}
+
+// Finish conversion of the sensor if its time has elapsed
+void settle(Sensor &sensor)
+{
+  if (sensor.converting && (int32_t)(hostMicros - sensor.tsConvEnd) >= 0)
+  {
+    sensor.converting = false;
+    sensor.scratchpad[0] = sensor.temperature & 0xFF;
+    sensor.scratchpad[1] = sensor.temperature >> 8;
+  }
+}
+
+bool isAlarm(Sensor &sensor)
+{
+  settle(sensor);
+  int8_t temp = (int16_t)(sensor.scratchpad[1] << 8 | sensor.scratchpad[0]) >> 4;
+  return temp <= (int8_t)sensor.scratchpad[3] ||
+         temp >= (int8_t)sensor.scratchpad[2];
+}
+
+template<typename Action>
+void forSelected(Action action)
+{
+  for (size_t i = 0; i < sensors.size(); i++)
+  {
+    if (selected < 0 || (size_t)selected == i)
+    {
+      action(sensors[i], i);
+    }
+  }
+}
+}
+
+void OneWireSim::begin(uint8_t count,
+                       bool parasitePower,
+                       uint8_t alarms,
+                       uint8_t convTimePercent)
+{
+  sensors.assign(count, Sensor());
+  parasite = parasitePower;
+  convPercent = convTimePercent;
+  resets_ = slots_ = conversions_ = 0;
+  state = STATE_ROM;
+  searchIndex = 0;
+  for (uint8_t i = 0; i < count; i++)
+  {
+    Sensor &sensor = sensors[i];
+    uint8_t rom[8] = { 0x28, i, (uint8_t)(i * 7), 0x5A, 0x06, 0x00, 0x00 };
+    rom[7] = crc(rom, 7);
+    memcpy(sensor.rom, rom, 8);
+    // Alarm sensors have high alarm bellow their temperature
+    sensor.eeprom[0] = i < alarms ? 15 : 125;
+    sensor.eeprom[1] = (uint8_t)-55;
+    sensor.eeprom[2] = 0x7F;
+    // Power-up temperature 85 centigrades
+    uint8_t scratchpad[9] = { 0x50, 0x05, sensor.eeprom[0], sensor.eeprom[1],
+                              sensor.eeprom[2], 0xFF, 0x0C, 0x10 };
+    memcpy(sensor.scratchpad, scratchpad, 8);
+    sensor.temperature = 20 * 16 + 4 * i;
+    sensor.converting = false;
+  }
+}
+
+uint8_t OneWire::reset()
+{
+  OneWireSim::reset();
+  state = STATE_ROM;
+  return !sensors.empty();
+}
+
+void OneWire::select(const uint8_t rom[8])
+{
+  OneWireSim::slots(8 * 9);
+  state = STATE_FUNCTION;
+  selected = (int)sensors.size();
+  for (size_t i = 0; i < sensors.size(); i++)
+  {
+    if (memcmp(sensors[i].rom, rom, 8) == 0)
+    {
+      selected = (int)i;
+      break;
+    }
+  }
+}
+
+void OneWire::skip()
+{
+  OneWireSim::slots(8);
+  state = STATE_FUNCTION;
+  selected = -1;
+}
+
+void OneWire::write(uint8_t v, uint8_t power)
+{
+  (void)power;
+  OneWireSim::slots(8);
+  switch (state)
+  {
+    case STATE_FUNCTION:
+      position = 0;
+      switch (v)
+      {
+        case CONVERT_T:
+          OneWireSim::conversions_++;
+          forSelected([](Sensor &sensor, size_t i) {
+            uint32_t duration = convMicros[(sensor.scratchpad[4] >> 5) & 3] /
+                                100 * (convPercent + i % 5);
+            sensor.tsConvEnd = hostMicros + duration;
+            sensor.converting = true;
+          });
+          break;
+        case WRITE_SCRATCHPAD:
+          state = STATE_WRITE;
+          break;
+        case READ_SCRATCHPAD:
+          state = STATE_READ;
+          break;
+        case COPY_SCRATCHPAD:
+          forSelected([](Sensor &sensor, size_t) {
+            memcpy(sensor.eeprom, sensor.scratchpad + 2, 3);
+          });
+          break;
+        case RECALL:
+          forSelected([](Sensor &sensor, size_t) {
+            memcpy(sensor.scratchpad + 2, sensor.eeprom, 3);
+          });
+          break;
+        case READ_POWER_SUPPLY:
+          state = STATE_POWER;
+          break;
+      }
+      break;
+    case STATE_WRITE:
+      forSelected([v](Sensor &sensor, size_t) {
+        if (position < 3)
+        {
+          sensor.scratchpad[2 + position] = v;
+        }
+      });
+      position++;
+      break;
+    default:
+      break;
+  }
+}
+
+void OneWire::write_bytes(const uint8_t *buf, uint16_t count, bool power)
+{
+  while (count--)
+  {
+    write(*buf++, power);
+  }
+}
+
+uint8_t OneWire::read()
+{
+  uint8_t value;
+  read_bytes(&value, 1);
+  return value;
+}
+
+void OneWire::read_bytes(uint8_t *buf, uint16_t count)
+{
+  OneWireSim::slots(8 * count);
+  // Idle bus reads ones
+  memset(buf, 0xFF, count);
+  if (state != STATE_READ || selected < 0 || (size_t)selected >= sensors.size())
+  {
+    return;
+  }
+  Sensor &sensor = sensors[selected];
+  settle(sensor);
+  sensor.scratchpad[8] = crc(sensor.scratchpad, 8);
+  for (uint16_t i = 0; i < count && position < 9; i++)
+  {
+    buf[i] = sensor.scratchpad[position++];
+  }
+}
+
+void OneWire::write_bit(uint8_t v)
+{
+  (void)v;
+  OneWireSim::slots(1);
+}
+
+uint8_t OneWire::read_bit()
+{
+  OneWireSim::slots(1);
+  if (state == STATE_POWER)
+  {
+    state = STATE_FUNCTION;
+    return !parasite;
+  }
+  // Any converting sensor holds the bus low
+  for (Sensor &sensor : sensors)
+  {
+    settle(sensor);
+    if (sensor.converting)
+    {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+void OneWire::reset_search() { searchIndex = 0; }
+
+bool OneWire::search(uint8_t *newAddr, bool search_mode)
+{
+  reset();
+  // Search command and three slots for every ROM bit
+  OneWireSim::slots(8 + 64 * 3);
+  while (searchIndex < sensors.size())
+  {
+    Sensor &sensor = sensors[searchIndex++];
+    if (search_mode || isAlarm(sensor))
+    {
+      memcpy(newAddr, sensor.rom, 8);
+      return true;
+    }
+  }
+  searchIndex = 0;
+  return false;
+}
+
+uint8_t OneWire::crc8(const uint8_t *addr, uint8_t len)
+{
+  uint8_t crc = 0;
+  while (len--)
+  {
+    uint8_t inbyte = *addr++;
+    for (uint8_t i = 8; i; i--)
+    {
+      uint8_t mix = (crc ^ inbyte) & 0x01;
+      crc >>= 1;
+      if (mix)
+      {
+        crc ^= 0x8C;
+      }
+      inbyte >>= 1;
+    }
+  }
+  return crc;
+}
@@ -0,0 +1,99 @@
+/*
+  NAME:
+  Simulated one-wire bus with temperature sensors DS18B20 for a host.
+
+  DESCRIPTION:
+  The shim provides the interface of the library OneWire used by the library
+  gbj_ds18b20 backed by a simulated bus instead of a GPIO pin.
+  - All instances share the one simulated bus configured by the static
+    methods of the class OneWireSim.
+  - Every bus primitive advances the virtual time by its nominal duration
+    at standard speed, so that the virtual time is the bus time.
+  - Sensors finish conversion in configured percentage of the maximal
+    conversion time according to datasheet with small deterministic
+    spread among sensors.
+
+  LICENSE:
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the MIT License (MIT).
+
+  CREDENTIALS:
+  Author: Libor Gabaj
+*/
+#ifndef ONEWIRE_H
+#define ONEWIRE_H
+
+#include "Arduino.h"
+
+class OneWireSim
+{
+public:
+  enum Timing : uint16_t
+  {
+    // Nominal durations of bus primitives in microseconds
+    RESET_MICROS = 960,
+    SLOT_MICROS = 70,
+  };
+
+  /*
+    Configure simulated bus
+
+    PARAMETERS:
+    sensors - Number of temperature sensors on the bus (1 ~ 255).
+    parasite - Flag about parasitic power mode of sensors.
+    alarms - Number of sensors with temperature in alarm state.
+    convPercent - Real conversion time in percentage of the maximal one.
+  */
+  static void begin(uint8_t sensors,
+                    bool parasite = false,
+                    uint8_t alarms = 0,
+                    uint8_t convPercent = 60);
+  static inline uint32_t getResets() { return resets_; }
+  static inline uint32_t getSlots() { return slots_; }
+  // Number of CONVERT_T commands on the bus
+  static inline uint32_t getConversions() { return conversions_; }
+  // Procedure called at every bus reset, e.g., for pausing a worker thread
+  static inline void setResetHook(void (*hook)()) { resetHook_ = hook; }
+
+private:
+  friend class OneWire;
+  static uint32_t resets_;
+  static uint32_t slots_;
+  static uint32_t conversions_;
+  static void (*resetHook_)();
+  static inline void reset()
+  {
+    if (resetHook_)
+    {
+      resetHook_();
+    }
+    resets_++;
+    hostMicros += RESET_MICROS;
+  }
+  static inline void slots(uint32_t count)
+  {
+    slots_ += count;
+    hostMicros += count * SLOT_MICROS;
+  }
+};
+
+class OneWire
+{
+public:
+  OneWire(uint8_t pin) { (void)pin; }
+  uint8_t reset();
+  void select(const uint8_t rom[8]);
+  void skip();
+  void write(uint8_t v, uint8_t power = 0);
+  void write_bytes(const uint8_t *buf, uint16_t count, bool power = 0);
+  uint8_t read();
+  void read_bytes(uint8_t *buf, uint16_t count);
+  void write_bit(uint8_t v);
+  uint8_t read_bit();
+  void depower() {}
+  void reset_search();
+  bool search(uint8_t *newAddr, bool search_mode = true);
+  static uint8_t crc8(const uint8_t *addr, uint8_t len);
+};
+
+#endif
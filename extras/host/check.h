@@ -0,0 +1,68 @@
+/*
+  NAME:
+  Common checks of host tests of the library gbj_ds18b20.
+
+  DESCRIPTION:
+  The header provides the checking macro and helpers shared by all host tests
+  running against the simulated bus.
+  - Every failed check is printed with its line and counted.
+  - Each test program consists of one translation unit, so the header defines
+    its globals and helpers directly.
+  - Build a test on a host from the root folder of the library by compiling
+    all source files from folders src and extras/host except other programs,
+    or by the makefile in the folder extras/host.
+
+  LICENSE:
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the MIT License (MIT).
+
+  CREDENTIALS:
+  Author: Libor Gabaj
+*/
+#ifndef CHECK_H
+#define CHECK_H
+
+#include "gbj_ds18b20.h"
+#include <cstdio>
+#include <cstring>
+
+static uint16_t failures = 0;
+
+#define CHECK(condition)                                                       \
+  do                                                                           \
+  {                                                                            \
+    if (!(condition))                                                          \
+    {                                                                          \
+      printf("FAIL line %d: %s\n", __LINE__, #condition);                      \
+      failures++;                                                              \
+    }                                                                          \
+  } while (0)
+
+// Raw temperature of a simulated sensor at 12 bits resolution
+inline int16_t temperature(uint8_t sensor) { return 20 * 16 + 4 * sensor; }
+
+// Store addresses of sensors on the bus up to the capacity and count them all
+inline uint8_t collectAddresses(gbj_ds18b20 &ds,
+                                gbj_ds18b20::Address *addresses,
+                                uint8_t capacity)
+{
+  uint8_t sensors = 0;
+  while (ds.isSuccess(ds.sensors()))
+  {
+    if (sensors < capacity)
+    {
+      memcpy(addresses[sensors], ds.getAddressRef(), gbj_ds18b20::ADDRESS_LEN);
+    }
+    sensors++;
+  }
+  return sensors;
+}
+
+// Print the summary and return the exit code of the test
+inline int report()
+{
+  printf("%s: %u failures\n", failures ? "FAIL" : "PASS", failures);
+  return failures ? 1 : 0;
+}
+
+#endif
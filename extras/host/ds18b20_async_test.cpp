@@ -0,0 +1,97 @@
+/*
+  NAME:
+  Testing the awaitable interface of the library gbj_ds18b20 on a host.
+
+  DESCRIPTION:
+  The program drives a coroutine with awaitable conversions by the scheduler
+  gbj_ds18b20_loop against the simulated bus and checks the results.
+  - The coroutine awaits bulk conversions and individual measurements in
+    cycles, so that it suspends again right at its resuming by the method
+    run() of the scheduler.
+  - The scheduler is checked to keep the coroutine suspended for the whole
+    conversion and to be idle after the end of the coroutine.
+  - The program prints every failed check and exits with code 1 on failure.
+  - Build like other host tests described in the header check.h in the
+    standard C++20 by the option -std=c++20.
+
+  USAGE:
+  ds18b20_async_test
+
+  LICENSE:
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the MIT License (MIT).
+
+  CREDENTIALS:
+  Author: Libor Gabaj
+*/
+#include "check.h"
+#include "gbj_ds18b20_async.h"
+#if !defined(__cpp_impl_coroutine)
+  #error "The test requires C++20 coroutines"
+#endif
+
+const uint8_t PIN_ONEWIRE = 4;
+const uint8_t SENSORS = 4;
+const uint8_t CYCLES = 3;
+// Conversion at 12 bits in 60 % of the maximal time at the simulated bus
+const uint32_t CONV_MICROS_MIN = 450000;
+
+// Progress of the coroutine
+uint8_t cycles = 0;
+uint8_t readings = 0;
+bool finished = false;
+
+gbj_ds18b20_task measure(gbj_ds18b20_async &ds,
+                         gbj_ds18b20::Address *addresses)
+{
+  for (cycles = 0; cycles < CYCLES; cycles++)
+  {
+    uint32_t tsStart = hostMicros;
+    CHECK(co_await ds.convertAsync() == gbj_ds18b20::SUCCESS);
+    CHECK(hostMicros - tsStart >= CONV_MICROS_MIN);
+    for (uint8_t i = 0; i < SENSORS; i++)
+    {
+      CHECK(ds.readSensor(addresses[i]) == gbj_ds18b20::SUCCESS);
+      CHECK(ds.getTemperatureRaw() == temperature(i));
+    }
+    // Suspend again within the same resumption by the scheduler
+    for (uint8_t i = 0; i < SENSORS; i++)
+    {
+      tsStart = hostMicros;
+      CHECK(co_await ds.readAsync(addresses[i]) == gbj_ds18b20::SUCCESS);
+      CHECK(hostMicros - tsStart >= CONV_MICROS_MIN);
+      CHECK(ds.getTemperatureRaw() == temperature(i));
+      readings++;
+    }
+  }
+  finished = true;
+}
+
+int main()
+{
+  OneWireSim::begin(SENSORS);
+  gbj_ds18b20_loop scheduler;
+  gbj_ds18b20_async ds = gbj_ds18b20_async(scheduler, PIN_ONEWIRE);
+  gbj_ds18b20::Address addresses[SENSORS];
+  CHECK(collectAddresses(ds, addresses, SENSORS) == SENSORS);
+  CHECK(scheduler.isIdle());
+  measure(ds, addresses);
+  // The coroutine is suspended at its first conversion right at calling
+  CHECK(!scheduler.isIdle());
+  CHECK(cycles == 0);
+  uint32_t runs = 0;
+  uint32_t conversions = OneWireSim::getConversions();
+  while (!scheduler.isIdle())
+  {
+    CHECK(scheduler.run() <= 1);
+    runs++;
+  }
+  CHECK(finished);
+  CHECK(readings == CYCLES * SENSORS);
+  CHECK(OneWireSim::getConversions() - conversions ==
+        CYCLES * (SENSORS + 1) - 1);
+  // Every conversion takes many runs of the scheduler
+  CHECK(runs > CYCLES * (SENSORS + 1));
+  CHECK(scheduler.run() == 0);
+  return report();
+}
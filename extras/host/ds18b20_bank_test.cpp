@@ -0,0 +1,89 @@
+/*
+  NAME:
+  Testing the sensor bank of the library gbj_ds18b20 on a host.
+
+  DESCRIPTION:
+  The program runs the class template gbj_ds18b20_bank against the simulated
+  bus with sensors at 12 bits resolution and checks the measurements.
+  - Buses with fewer, exactly, and more sensors than the capacity of the bank
+    are checked in both power modes. Bulk conversion should end at the bank
+    resolution even with sensors above the capacity on the bus.
+  - A bank with different power mode than the bus is checked to detect no
+    sensor.
+  - The program prints sizes of the bank and of the class gbj_ds18b20 in RAM
+    of the host for comparison.
+  - The program prints every failed check and exits with code 1 on failure.
+  - Build like other host tests described in the header check.h.
+
+  USAGE:
+  ds18b20_bank_test
+
+  LICENSE:
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the MIT License (MIT).
+
+  CREDENTIALS:
+  Author: Libor Gabaj
+*/
+#include "check.h"
+#include "gbj_ds18b20_bank.h"
+
+const uint8_t PIN_ONEWIRE = 4;
+const uint8_t CAPACITY = 3;
+const uint8_t RESOLUTION = 10;
+// Time of bus primitives starting a conversion
+const uint8_t BUS_MILLIS = 5;
+
+// Raw temperature of a simulated sensor at the bank resolution
+int16_t temperatureBank(uint8_t sensor) { return temperature(sensor) & ~0x03; }
+
+template<gbj_ds18b20::PowerModes PowerMode>
+void testSensors(uint8_t sensors)
+{
+  bool parasite = PowerMode == gbj_ds18b20::POWER_PARASITE;
+  OneWireSim::begin(sensors, parasite);
+  gbj_ds18b20_bank<CAPACITY, RESOLUTION, PowerMode> bank(PIN_ONEWIRE);
+  uint8_t detected = sensors < CAPACITY ? sensors : CAPACITY;
+  CHECK(bank.getLastResult() == gbj_ds18b20::SUCCESS);
+  CHECK(bank.getSensors() == detected);
+  for (uint8_t cycle = 0; cycle < 2; cycle++)
+  {
+    uint32_t tsStart = millis();
+    CHECK(bank.conversion() == gbj_ds18b20::SUCCESS);
+    CHECK(millis() - tsStart <= bank.getConvMillis() + BUS_MILLIS);
+    CHECK(bank.measure() == gbj_ds18b20::SUCCESS);
+    for (uint8_t i = 0; i < detected; i++)
+    {
+      CHECK(bank.getAddressRef(i)[1] == i);
+      CHECK(bank.getTemperatureRaw(i) == temperatureBank(i));
+    }
+  }
+  // All sensors on the bus at the bank resolution
+  gbj_ds18b20 ds = gbj_ds18b20(PIN_ONEWIRE);
+  CHECK(collectAddresses(ds, 0, 0) == sensors);
+  CHECK(ds.getResolutionBus() == RESOLUTION - 9);
+}
+
+void testPowerMode()
+{
+  OneWireSim::begin(CAPACITY);
+  gbj_ds18b20_bank<CAPACITY, RESOLUTION, gbj_ds18b20::POWER_PARASITE> bank(
+    PIN_ONEWIRE);
+  CHECK(bank.getLastResult() == gbj_ds18b20::ERROR_POWER_MODE);
+  CHECK(bank.getSensors() == 0);
+}
+
+int main()
+{
+  const uint8_t sensors[] = { CAPACITY - 1, CAPACITY, CAPACITY + 2 };
+  for (uint8_t sensor : sensors)
+  {
+    testSensors<gbj_ds18b20::POWER_EXTERNAL>(sensor);
+    testSensors<gbj_ds18b20::POWER_PARASITE>(sensor);
+  }
+  testPowerMode();
+  printf("sizeof gbj_ds18b20_bank<4>: %u B, gbj_ds18b20: %u B\n",
+         (unsigned)sizeof(gbj_ds18b20_bank<4>),
+         (unsigned)sizeof(gbj_ds18b20));
+  return report();
+}
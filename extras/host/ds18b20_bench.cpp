@@ -0,0 +1,336 @@
+/*
+  NAME:
+  Benchmarks of hot paths of the library gbj_ds18b20 on a host.
+
+  DESCRIPTION:
+  The program measures processor time and simulated bus time of key
+  operations of the library against the simulated bus with various numbers
+  of sensors in both power modes.
+  - Every result is printed as one JSON object per line with the name of
+    the operation, number of sensors, power mode, percentage and number of
+    sensors in alarm state, repetitions, processor time and bus time per
+    operation, and numbers of bus resets and time slots per operation.
+  - The number of sensors in alarm state is rounded up, so that at least one
+    sensor is in alarm state for a nonzero percentage.
+  - Processor time includes the overhead of the bus simulator. Bus time is
+    virtual and deterministic, so that it does not depend on the host.
+  - Checksum operations are measured without the bus as processor time per
+    scratchpad in a batch of scratchpads of all sensors. The bit-wise
+    checksum of the library OneWire per frame is compared with the table
+    driven checksum per frame and with the batch validation.
+  - With the option --check the program compares bus times with a baseline
+    report and fails if any of them has grown, so that regressions of bus
+    time are caught automatically. The baseline of the current library is
+    in the file bench_baseline.jsonl.
+  - Build on a host by the target bench of the makefile in the folder
+    extras/host. The target check runs the program against the baseline.
+
+  USAGE:
+  ds18b20_bench [--check <baseline file>]
+
+  LICENSE:
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the MIT License (MIT).
+
+  CREDENTIALS:
+  Author: Libor Gabaj
+*/
+#include "gbj_ds18b20.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+
+const uint8_t PIN_ONEWIRE = 4;
+const uint8_t SENSORS[] = { 1, 10, 50, 100 };
+const uint8_t ALARM_PERCENTS[] = { 0, 10, 50, 100 };
+// Scratchpads in a batch and its repetitions for checksum operations
+const uint8_t CRC_FRAMES = 32;
+const uint32_t CRC_ROUNDS = 20000;
+
+struct Result
+{
+  const char *name;
+  uint8_t sensors;
+  bool parasite;
+  uint8_t alarmPercent;
+  uint8_t alarms;
+  uint32_t repetitions;
+  double cpuNanos;
+  double busMicros;
+  double resets;
+  double slots;
+};
+
+std::map<std::string, double> baseline;
+bool regression = false;
+
+std::string key(const char *name,
+                unsigned sensors,
+                const char *power,
+                unsigned alarmPercent)
+{
+  char text[80];
+  snprintf(text,
+           sizeof(text),
+           "%s/%u/%s/%u",
+           name,
+           sensors,
+           power,
+           alarmPercent);
+  return text;
+}
+
+void report(const Result &result)
+{
+  const char *power = result.parasite ? "parasite" : "external";
+  printf("{\"name\": \"%s\", \"sensors\": %u, \"power\": \"%s\", "
+         "\"alarm_percent\": %u, \"alarm_sensors\": %u, \"repetitions\": %u, "
+         "\"cpu_ns\": %.1f, \"bus_us\": %.1f, \"resets\": %.1f, "
+         "\"slots\": %.1f}\n",
+         result.name,
+         result.sensors,
+         power,
+         result.alarmPercent,
+         result.alarms,
+         result.repetitions,
+         result.cpuNanos,
+         result.busMicros,
+         result.resets,
+         result.slots);
+  std::map<std::string, double>::iterator it = baseline.find(
+    key(result.name, result.sensors, power, result.alarmPercent));
+  if (it != baseline.end() && result.busMicros > it->second)
+  {
+    fprintf(stderr,
+            "Regression %s: bus time %.1f us, baseline %.1f us\n",
+            it->first.c_str(),
+            result.busMicros,
+            it->second);
+    regression = true;
+  }
+}
+
+bool loadBaseline(const char *fileName)
+{
+  FILE *file = fopen(fileName, "r");
+  if (!file)
+  {
+    perror(fileName);
+    return false;
+  }
+  char line[512];
+  while (fgets(line, sizeof(line), file))
+  {
+    char name[40], power[16];
+    unsigned sensors, alarmPercent, alarms, repetitions;
+    double cpuNanos, busMicros;
+    if (sscanf(line,
+               "{\"name\": \"%39[^\"]\", \"sensors\": %u, \"power\": "
+               "\"%15[^\"]\", \"alarm_percent\": %u, \"alarm_sensors\": %u, "
+               "\"repetitions\": %u, \"cpu_ns\": %lf, \"bus_us\": %lf",
+               name,
+               &sensors,
+               power,
+               &alarmPercent,
+               &alarms,
+               &repetitions,
+               &cpuNanos,
+               &busMicros) == 8)
+    {
+      baseline[key(name, sensors, power, alarmPercent)] = busMicros;
+    }
+  }
+  fclose(file);
+  // Baseline in another format would silently pass every check
+  if (baseline.empty())
+  {
+    fprintf(stderr, "%s: no results\n", fileName);
+    return false;
+  }
+  return true;
+}
+
+// Number of sensors in alarm state rounded up
+uint8_t alarmSensors(uint8_t sensors, uint8_t alarmPercent)
+{
+  return (sensors * alarmPercent + 99) / 100;
+}
+
+// Measure repeated operation and report averages per repetition
+template<typename Operation>
+void measure(const char *name,
+             uint8_t sensors,
+             bool parasite,
+             uint8_t alarmPercent,
+             uint32_t repetitions,
+             Operation operation)
+{
+  uint32_t tsBus = hostMicros;
+  uint32_t resets = OneWireSim::getResets();
+  uint32_t slots = OneWireSim::getSlots();
+  std::chrono::steady_clock::time_point tsCpu =
+    std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < repetitions; i++)
+  {
+    operation(i);
+  }
+  double cpuNanos = std::chrono::duration<double, std::nano>(
+                      std::chrono::steady_clock::now() - tsCpu)
+                      .count();
+  Result result = { name,
+                    sensors,
+                    parasite,
+                    alarmPercent,
+                    alarmSensors(sensors, alarmPercent),
+                    repetitions,
+                    cpuNanos / repetitions,
+                    (double)(hostMicros - tsBus) / repetitions,
+                    (double)(OneWireSim::getResets() - resets) / repetitions,
+                    (double)(OneWireSim::getSlots() - slots) / repetitions };
+  report(result);
+}
+
+void benchBus(uint8_t sensors, bool parasite)
+{
+  OneWireSim::begin(sensors, parasite);
+  gbj_ds18b20 ds = gbj_ds18b20(PIN_ONEWIRE);
+  ds.conversion();
+  volatile float sink = 0;
+
+  measure("devices", sensors, parasite, 0, 10, [&](uint32_t) {
+    ds.devices();
+  });
+  measure("sensors", sensors, parasite, 0, 10, [&](uint32_t) {
+    while (ds.isSuccess(ds.sensors()))
+    {
+      sink = sink + ds.getTemperature();
+    }
+  });
+  measure("conversion", sensors, parasite, 0, 5, [&](uint32_t) {
+    ds.conversion();
+  });
+  gbj_ds18b20::Address addresses[255];
+  int16_t temperatures[255];
+  gbj_ds18b20::Snapshot snapshot = {
+    addresses, temperatures, NULL, NULL, sensors, 0, 0
+  };
+  measure("readAll", sensors, parasite, 0, 5, [&](uint32_t) {
+    ds.readAll(snapshot);
+  });
+
+  // Operations on one selected sensor
+  ds.sensors();
+  measure("getTemperature", sensors, parasite, 0, 1000000, [&](uint32_t) {
+    sink = sink + ds.getTemperature();
+  });
+  measure("cacheResolutionBits", sensors, parasite, 0, 1000000, [&](uint32_t i) {
+    ds.cacheResolutionBits(9 + (i & 3));
+  });
+  ds.getCache();
+  measure("writeScratchpad", sensors, parasite, 0, 10, [&](uint32_t) {
+    ds.setCache();
+  });
+  ds.reset_search();
+
+  for (uint8_t alarmPercent : ALARM_PERCENTS)
+  {
+    OneWireSim::begin(sensors, parasite, alarmSensors(sensors, alarmPercent));
+    gbj_ds18b20 dsAlarm = gbj_ds18b20(PIN_ONEWIRE);
+    dsAlarm.conversion();
+    measure("alarms", sensors, parasite, alarmPercent, 10, [&](uint32_t) {
+      while (dsAlarm.isAlarm(dsAlarm.alarms()))
+      {
+        sink = sink + dsAlarm.getTemperature();
+      }
+    });
+  }
+}
+
+// Measure checksum validation of a batch and report averages per frame
+template<typename Operation>
+void measureCrc(const char *name, Operation operation)
+{
+  uint32_t valid = 0;
+  std::chrono::steady_clock::time_point tsCpu =
+    std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < CRC_ROUNDS; i++)
+  {
+    valid += operation();
+  }
+  double cpuNanos = std::chrono::duration<double, std::nano>(
+                      std::chrono::steady_clock::now() - tsCpu)
+                      .count();
+  uint32_t frames = CRC_ROUNDS * CRC_FRAMES;
+  Result result = {
+    name, CRC_FRAMES, false, 0, 0, frames, cpuNanos / frames, 0, 0, 0
+  };
+  report(result);
+  // Every other frame is corrupted
+  if (valid != frames / 2)
+  {
+    fprintf(stderr, "Wrong %s: %u valid frames of %u\n", name, valid, frames);
+    regression = true;
+  }
+}
+
+void benchCrc()
+{
+  gbj_ds18b20::Scratchpad frames[CRC_FRAMES];
+  for (uint8_t i = 0; i < CRC_FRAMES; i++)
+  {
+    for (uint8_t j = 0; j < gbj_ds18b20::SCRATCHPAD_LEN - 1; j++)
+    {
+      frames[i][j] = 31 * i + 7 * j;
+    }
+    frames[i][gbj_ds18b20::SCRATCHPAD_LEN - 1] =
+      OneWire::crc8(frames[i], gbj_ds18b20::SCRATCHPAD_LEN - 1) ^ (i & 1);
+  }
+  measureCrc("crcOneWire", [&]() {
+    uint16_t valid = 0;
+    for (uint8_t i = 0; i < CRC_FRAMES; i++)
+    {
+      valid += OneWire::crc8(frames[i], gbj_ds18b20::SCRATCHPAD_LEN) == 0;
+    }
+    return valid;
+  });
+  measureCrc("crcIsValid", [&]() {
+    uint16_t valid = 0;
+    for (uint8_t i = 0; i < CRC_FRAMES; i++)
+    {
+      valid +=
+        gbj_ds18b20_crc::isValid(frames[i], gbj_ds18b20::SCRATCHPAD_LEN);
+    }
+    return valid;
+  });
+  measureCrc("crcValidate", [&]() {
+    return gbj_ds18b20_crc::validate(
+      frames[0], gbj_ds18b20::SCRATCHPAD_LEN, CRC_FRAMES, NULL);
+  });
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc > 1)
+  {
+    if (argc != 3 || strcmp(argv[1], "--check") != 0)
+    {
+      fprintf(stderr, "usage: %s [--check <baseline file>]\n", argv[0]);
+      return 2;
+    }
+    if (!loadBaseline(argv[2]))
+    {
+      return 2;
+    }
+  }
+  for (bool parasite : { false, true })
+  {
+    for (uint8_t sensors : SENSORS)
+    {
+      benchBus(sensors, parasite);
+    }
+  }
+  benchCrc();
+  return regression;
+}
@@ -0,0 +1,155 @@
+/*
+  NAME:
+  Testing conversion statistics of the library gbj_ds18b20 on a host.
+
+  DESCRIPTION:
+  The program checks recording of measured conversion times to histograms
+  and calibrated waiting for conversion against the simulated bus.
+  - Conversion times are recorded by blocking conversions and by polling
+    the end of non-blocking conversions in external power mode, including
+    late polls longer than the range of a histogram.
+  - Histograms recorded in external power mode calibrate waiting for
+    conversion in parasitic power mode, which should still read fresh
+    temperatures.
+  - The program prints every failed check and exits with code 1 on failure.
+  - Build like other host tests described in the header check.h with the
+    macro defined by the option -DGBJ_DS18B20_CONV_STATS.
+
+  USAGE:
+  ds18b20_conv_stats_test
+
+  LICENSE:
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the MIT License (MIT).
+
+  CREDENTIALS:
+  Author: Libor Gabaj
+*/
+#include "check.h"
+#if !defined(GBJ_DS18B20_CONV_STATS)
+  #error "The test requires the macro GBJ_DS18B20_CONV_STATS"
+#endif
+
+const uint8_t PIN_ONEWIRE = 4;
+const uint8_t SENSORS = 4;
+// Resolution codes for 9 and 12 bits
+const uint8_t RES_9 = 0;
+const uint8_t RES_12 = 3;
+// Real conversion time at 12 bits in percentage of the maximal one
+const uint8_t CONV_PERCENT = 60;
+const uint16_t CONV_MILLIS_MAX = 750 * (CONV_PERCENT + SENSORS) / 100;
+
+
+void testHistogramClamp()
+{
+  gbj_ds18b20_histogram histogram(94);
+  for (uint8_t i = 0; i < 40; i++)
+  {
+    histogram.record(1540);
+  }
+  CHECK(histogram.getCount(gbj_ds18b20_histogram::BUCKETS - 1) == 40);
+  CHECK(histogram.getPercentile(99) ==
+        gbj_ds18b20_histogram::BUCKETS * histogram.getBucketMillis());
+  histogram.reset();
+  histogram.record(70000UL);
+  CHECK(histogram.getCount(0) == 0);
+  CHECK(histogram.getCount(gbj_ds18b20_histogram::BUCKETS - 1) == 1);
+}
+
+void testBulkRecording(gbj_ds18b20 &ds)
+{
+  gbj_ds18b20_histogram &histogram = ds.getConvStats()->getHistogram(RES_12);
+  histogram.reset();
+  for (uint8_t i = 0; i < 40; i++)
+  {
+    CHECK(ds.conversion() == gbj_ds18b20::SUCCESS);
+  }
+  CHECK(histogram.getSamples() == 40);
+  CHECK(histogram.getPercentile(99) >= CONV_MILLIS_MAX);
+  CHECK(histogram.getPercentile(99) < ds.getConvMaxMillis(RES_12));
+}
+
+void testPollingRecording(gbj_ds18b20 &ds, gbj_ds18b20::Address address)
+{
+  gbj_ds18b20_histogram &histogram = ds.getConvStats()->getHistogram(RES_12);
+  histogram.reset();
+  // Bulk conversion without known resolution of the sensor is not recorded
+  CHECK(ds.conversionStart(address) == gbj_ds18b20::SUCCESS);
+  while (!ds.isConversionDone())
+    ;
+  CHECK(histogram.getSamples() == 0);
+  // Repeated polls after the end of conversion are recorded once
+  CHECK(ds.conversionStart(address, 12) == gbj_ds18b20::SUCCESS);
+  while (!ds.isConversionDone())
+    ;
+  for (uint8_t i = 0; i < 5; i++)
+  {
+    CHECK(ds.isConversionDone());
+  }
+  CHECK(histogram.getSamples() == 1);
+  CHECK(histogram.getPercentile(99) < ds.getConvMaxMillis(RES_12));
+  // Late poll beyond the range of 16-bit milliseconds
+  CHECK(ds.conversionStart(address, 12) == gbj_ds18b20::SUCCESS);
+  delay(70000UL);
+  CHECK(ds.isConversionDone());
+  CHECK(histogram.getSamples() == 2);
+  CHECK(histogram.getCount(0) == 0);
+  CHECK(histogram.getCount(gbj_ds18b20_histogram::BUCKETS - 1) == 1);
+}
+
+void testCalibratedWait(gbj_ds18b20_histogram &calibration,
+                        gbj_ds18b20::Address *addresses)
+{
+  OneWireSim::begin(SENSORS, true, 0, CONV_PERCENT);
+  gbj_ds18b20 ds = gbj_ds18b20(PIN_ONEWIRE);
+  CHECK(ds.isPowerParasite());
+  uint16_t convMaxMillis = ds.getConvMaxMillis(RES_12);
+  CHECK(ds.getConvWaitMillis(RES_12) == convMaxMillis);
+  // Out of range resolution is masked
+  CHECK(ds.getConvWaitMillis(RES_12 | 0x04) == convMaxMillis);
+  gbj_ds18b20::ConvStats convStats;
+  convStats.getHistogram(RES_12) = calibration;
+  convStats.calibrated = true;
+  convStats.marginMillis = 10;
+  // Calibrated statistics not attached yet
+  CHECK(ds.getConvWaitMillis(RES_12) == convMaxMillis);
+  ds.setConvStats(&convStats);
+  uint16_t waitMillis = ds.getConvWaitMillis(RES_12);
+  CHECK(waitMillis == calibration.getPercentile(99) + 10);
+  CHECK(waitMillis >= CONV_MILLIS_MAX);
+  CHECK(waitMillis < convMaxMillis);
+  // Calibrated waiting still reads fresh temperatures
+  uint32_t tsStart = millis();
+  CHECK(ds.conversion() == gbj_ds18b20::SUCCESS);
+  CHECK(millis() - tsStart >= waitMillis);
+  CHECK(millis() - tsStart < convMaxMillis);
+  for (uint8_t i = 0; i < SENSORS; i++)
+  {
+    CHECK(ds.readSensor(addresses[i]) == gbj_ds18b20::SUCCESS);
+    CHECK(ds.getTemperatureRaw() == temperature(i));
+  }
+  // Too few samples
+  convStats.getHistogram(RES_12).reset();
+  convStats.getHistogram(RES_12).record(100);
+  CHECK(ds.getConvWaitMillis(RES_12) == convMaxMillis);
+}
+
+int main()
+{
+  testHistogramClamp();
+  OneWireSim::begin(SENSORS, false, 0, CONV_PERCENT);
+  gbj_ds18b20 ds = gbj_ds18b20(PIN_ONEWIRE);
+  gbj_ds18b20::Address addresses[SENSORS];
+  CHECK(collectAddresses(ds, addresses, SENSORS) == SENSORS);
+  CHECK(ds.getResolutionBus() == RES_12);
+  // Conversion without attached statistics records nowhere
+  CHECK(ds.getConvStats() == 0);
+  CHECK(ds.conversion() == gbj_ds18b20::SUCCESS);
+  gbj_ds18b20::ConvStats convStats;
+  ds.setConvStats(&convStats);
+  testBulkRecording(ds);
+  gbj_ds18b20_histogram calibration = convStats.getHistogram(RES_12);
+  testPollingRecording(ds, addresses[SENSORS - 1]);
+  testCalibratedWait(calibration, addresses);
+  return report();
+}
@@ -0,0 +1,146 @@
+/*
+  NAME:
+  Recording and replaying traces of one-wire bus transactions on a host.
+
+  DESCRIPTION:
+  The program runs cycles of reading all sensors by the method readAll()
+  of the library gbj_ds18b20 either against the simulated bus while recording
+  the trace, or against a trace recorded in the field or on the host.
+  - Both modes print the same report per cycle, so that reports of recording
+    and replaying the same trace are identical unless the library changed its
+    bus behavior. The replaying mode reports also divergence from the trace.
+  - Traces recorded in the field should be produced by the same sequence of
+    calls, i.e., construction of the instance followed by cycles of readAll().
+  - Build on a host by the makefile in the folder extras/host, which
+    defines the macro GBJ_DS18B20_TRACE. Its target test_replay checks that
+    recording and replaying a trace produce identical reports.
+
+  USAGE:
+  ds18b20_replay record <trace file> [sensors] [cycles] [external|parasite]
+  ds18b20_replay replay <trace file>
+
+  LICENSE:
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the MIT License (MIT).
+
+  CREDENTIALS:
+  Author: Libor Gabaj
+*/
+#include "gbj_ds18b20.h"
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#if !defined(GBJ_DS18B20_TRACE)
+  #error "The program requires the macro GBJ_DS18B20_TRACE"
+#endif
+
+const uint8_t PIN_ONEWIRE = 4;
+const uint16_t TRACE_CAPACITY = 0xFFFF;
+
+void clockHook(uint32_t micros)
+{
+  // Keep virtual time monotonic after delays not recorded in the trace
+  hostMicros = max(hostMicros, micros);
+}
+
+void report(uint32_t cycle,
+            gbj_ds18b20::ResultCodes result,
+            gbj_ds18b20::Snapshot &snapshot,
+            uint32_t cycleMicros)
+{
+  printf("cycle=%u result=%u sensors=%u bus_us=%u temps=",
+         cycle,
+         result,
+         snapshot.count,
+         cycleMicros);
+  for (uint8_t i = 0; i < snapshot.count; i++)
+  {
+    printf("%s%d", i ? "," : "", snapshot.temperatures[i]);
+  }
+  printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+  // Power mode of the simulated bus by word, external by default
+  bool parasite = argc > 5 && strcmp(argv[5], "parasite") == 0;
+  if (argc < 3 || (argc > 5 && !parasite && strcmp(argv[5], "external") != 0))
+  {
+    fprintf(stderr,
+            "usage: %s record <trace> [sensors] [cycles] [external|parasite]\n"
+            "       %s replay <trace>\n",
+            argv[0],
+            argv[0]);
+    return 2;
+  }
+  bool recording = strcmp(argv[1], "record") == 0;
+  std::vector<uint8_t> buffer(TRACE_CAPACITY);
+  gbj_ds18b20_trace trace;
+  uint32_t cycles = 0xFFFFFFFF;
+  if (recording)
+  {
+    OneWireSim::begin(argc > 3 ? atoi(argv[3]) : 4, parasite);
+    cycles = argc > 4 ? atoi(argv[4]) : 3;
+    trace.record(buffer.data(), buffer.size());
+  }
+  else
+  {
+    FILE *file = fopen(argv[2], "rb");
+    if (!file)
+    {
+      perror(argv[2]);
+      return 2;
+    }
+    size_t length = fread(buffer.data(), 1, buffer.size(), file);
+    fclose(file);
+    // Empty simulated bus, so that nothing is answered out of the trace
+    OneWireSim::begin(0);
+    if (!trace.replay(buffer.data(), length, clockHook))
+    {
+      fprintf(stderr, "%s: not a trace\n", argv[2]);
+      return 2;
+    }
+  }
+
+  gbj_ds18b20 ds = gbj_ds18b20(PIN_ONEWIRE, 0, 0, &trace);
+  const uint8_t capacity = 255;
+  gbj_ds18b20::Address addresses[capacity];
+  int16_t temperatures[capacity];
+  gbj_ds18b20::Snapshot snapshot = {
+    addresses, temperatures, NULL, NULL, capacity, 0, 0
+  };
+  for (uint32_t cycle = 0; cycle < cycles; cycle++)
+  {
+    if (!recording && !trace.isReplaying())
+    {
+      break;
+    }
+    uint32_t tsCycle = hostMicros;
+    gbj_ds18b20::ResultCodes result = ds.readAll(snapshot);
+    // Cycle interrupted by the end of the trace is not reported
+    if (!recording && !trace.isReplaying() && !trace.isDiverged())
+    {
+      break;
+    }
+    report(cycle, result, snapshot, hostMicros - tsCycle);
+  }
+  trace.stop();
+
+  if (recording)
+  {
+    FILE *file = fopen(argv[2], "wb");
+    if (!file)
+    {
+      perror(argv[2]);
+      return 2;
+    }
+    fwrite(buffer.data(), 1, trace.getLength(), file);
+    fclose(file);
+  }
+  printf("transactions=%u trace_bytes=%u overflow=%d diverged=%d\n",
+         trace.getTransactions(),
+         trace.getLength(),
+         trace.isOverflow(),
+         trace.isDiverged());
+  return trace.isDiverged() || trace.isOverflow();
+}
@@ -0,0 +1,154 @@
+/*
+  NAME:
+  Testing the sampling scheduler of the library gbj_ds18b20 on a host.
+
+  DESCRIPTION:
+  The program runs the class template gbj_ds18b20_sampler against the
+  simulated bus in virtual time and checks the samples.
+  - Sensors lowered to the same resolution are checked to be sampled by one
+    bulk conversion, because the bus resolution is detected again.
+  - Sensors with lower resolution than other sensors on the bus are checked
+    to be sampled by individual conversions with their own periods.
+  - Registering a sensor while waiting for a conversion or without a free
+    slot is checked to fail.
+  - The program prints every failed check and exits with code 1 on failure.
+  - Build like other host tests described in the header check.h.
+
+  USAGE:
+  ds18b20_sampler_test
+
+  LICENSE:
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the MIT License (MIT).
+
+  CREDENTIALS:
+  Author: Libor Gabaj
+*/
+#include "check.h"
+#include "gbj_ds18b20_sampler.h"
+
+const uint8_t PIN_ONEWIRE = 4;
+const uint8_t SENSORS = 4;
+// Resolution codes for 9 and 12 bits
+const uint8_t RES_9 = 0;
+const uint8_t RES_12 = 3;
+
+gbj_ds18b20::Address addresses[SENSORS];
+
+// Raw temperature of a simulated sensor at 9 bits resolution
+int16_t temperature9(uint8_t sensor) { return temperature(sensor) & ~0x07; }
+
+// Simulated bus with all sensors at 12 bits and their addresses
+void begin(gbj_ds18b20 &ds)
+{
+  OneWireSim::begin(SENSORS);
+  ds.devices();
+  CHECK(collectAddresses(ds, addresses, SENSORS) == SENSORS);
+}
+
+// Run the scheduler in virtual time and count cycles with new samples
+template<uint8_t N>
+uint16_t runFor(gbj_ds18b20_sampler<N> &sampler, uint32_t periodMillis)
+{
+  uint16_t cycles = 0;
+  uint32_t tsStart = millis();
+  while (millis() - tsStart < periodMillis)
+  {
+    if (sampler.run())
+    {
+      cycles++;
+    }
+    else if (!sampler.isBusy())
+    {
+      delay(1);
+    }
+  }
+  return cycles;
+}
+
+void testBulk(gbj_ds18b20 &ds)
+{
+  begin(ds);
+  CHECK(ds.getResolutionBus() == RES_12);
+  gbj_ds18b20_sampler<SENSORS> sampler(ds);
+  for (uint8_t i = 0; i < SENSORS; i++)
+  {
+    CHECK(sampler.add(addresses[i], 1000, 9) == gbj_ds18b20::SUCCESS);
+  }
+  // Lowered resolution of all sensors is the bus resolution
+  CHECK(ds.getResolutionBus() == RES_9);
+  uint32_t conversions = OneWireSim::getConversions();
+  uint16_t cycles = runFor(sampler, 5000);
+  // Window of 5 periods with the first sample due already
+  CHECK(cycles >= 5 && cycles <= 6);
+  CHECK(OneWireSim::getConversions() - conversions == cycles);
+  CHECK(sampler.getBusMillis() <= cycles * ds.getConvMaxMillis(RES_9));
+  for (uint8_t i = 0; i < SENSORS; i++)
+  {
+    CHECK(sampler.getLastResult(i) == gbj_ds18b20::SUCCESS);
+    CHECK(sampler.getTemperatureRaw(i) == temperature9(i));
+    CHECK(sampler.getTimestamp(i) == sampler.getTimestamp(0));
+  }
+}
+
+void testIndividual(gbj_ds18b20 &ds)
+{
+  begin(ds);
+  gbj_ds18b20_sampler<2> sampler(ds);
+  CHECK(sampler.add(addresses[0], 500, 9) == gbj_ds18b20::SUCCESS);
+  CHECK(sampler.add(addresses[1], 1500, 9) == gbj_ds18b20::SUCCESS);
+  // Other sensors keep the bus resolution
+  CHECK(ds.getResolutionBus() == RES_12);
+  CHECK(sampler.add(addresses[2], 1000) == gbj_ds18b20::ERROR_NO_SENSOR);
+  uint32_t tsStart = millis();
+  uint32_t conversions = OneWireSim::getConversions();
+  uint16_t samples[2] = { 0, 0 };
+  uint32_t tsSample[2] = { 0, 0 };
+  while (millis() - tsStart < 6000)
+  {
+    runFor(sampler, 1);
+    for (uint8_t i = 0; i < 2; i++)
+    {
+      if (sampler.getTimestamp(i) != tsSample[i])
+      {
+        tsSample[i] = sampler.getTimestamp(i);
+        samples[i]++;
+        CHECK(sampler.getLastResult(i) == gbj_ds18b20::SUCCESS);
+        CHECK(sampler.getTemperatureRaw(i) == temperature9(i));
+      }
+    }
+  }
+  // Window of 12 and 4 periods with the first samples due already
+  CHECK(samples[0] >= 12 && samples[0] <= 13);
+  CHECK(samples[1] >= 4 && samples[1] <= 5);
+  // Every sample by its own conversion at its own resolution
+  CHECK(OneWireSim::getConversions() - conversions ==
+        (uint32_t)(samples[0] + samples[1]));
+  CHECK(sampler.getBusMillis() <=
+        (samples[0] + samples[1]) * ds.getConvMaxMillis(RES_9));
+}
+
+void testAddBusy(gbj_ds18b20 &ds)
+{
+  begin(ds);
+  gbj_ds18b20_sampler<SENSORS> sampler(ds);
+  CHECK(sampler.add(addresses[0], 1000) == gbj_ds18b20::SUCCESS);
+  CHECK(!sampler.run());
+  CHECK(sampler.isBusy());
+  CHECK(sampler.add(addresses[1], 1000) == gbj_ds18b20::ERROR_NO_SENSOR);
+  CHECK(sampler.getSensors() == 1);
+  while (!sampler.run())
+    ;
+  CHECK(sampler.add(addresses[1], 1000) == gbj_ds18b20::SUCCESS);
+  CHECK(sampler.getSensors() == 2);
+}
+
+int main()
+{
+  OneWireSim::begin(SENSORS);
+  gbj_ds18b20 ds = gbj_ds18b20(PIN_ONEWIRE);
+  testBulk(ds);
+  testIndividual(ds);
+  testAddBusy(ds);
+  return report();
+}
@@ -0,0 +1,162 @@
+/*
+  NAME:
+  Testing the thread-safe service of the library gbj_ds18b20 on a host.
+
+  DESCRIPTION:
+  The program submits jobs to the class gbj_ds18b20_service from several
+  threads against the simulated bus and checks the readings.
+  - Measurement jobs pending at the same time are checked to be served by
+    exactly one bulk conversion. The worker thread is paused by the reset
+    hook of the simulated bus, until all threads have submitted their jobs.
+  - Configuration jobs from several threads are checked to be written to
+    their sensors and not mixed up.
+  - The program prints every failed check and exits with code 1 on failure.
+  - Build like other host tests described in the header check.h with
+    threads enabled by the option -pthread.
+
+  USAGE:
+  ds18b20_service_test
+
+  LICENSE:
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the MIT License (MIT).
+
+  CREDENTIALS:
+  Author: Libor Gabaj
+*/
+#include "check.h"
+#include "gbj_ds18b20_service.h"
+#include <vector>
+
+const uint8_t PIN_ONEWIRE = 4;
+const uint8_t SENSORS = 8;
+const uint8_t THREADS = 4;
+
+typedef gbj_ds18b20_service::Reading Reading;
+
+std::mutex gate;
+gbj_ds18b20::Address addresses[SENSORS];
+
+// Pause the worker thread at bus reset while the gate is locked
+void resetHook()
+{
+  std::lock_guard<std::mutex> lock(gate);
+}
+
+// Wait until the worker takes all pending jobs or the queue reaches a size
+void waitPending(gbj_ds18b20_service &service, size_t pending)
+{
+  while (service.getPending() != pending)
+  {
+    std::this_thread::yield();
+  }
+}
+
+void testMeasureMerged(gbj_ds18b20_service &service)
+{
+  // Block the worker in a read job, so that measurements queue up
+  gate.lock();
+  std::future<Reading> blocker = service.read(addresses[0]);
+  waitPending(service, 0);
+  std::vector<std::future<Reading> > readings(SENSORS);
+  std::vector<std::thread> threads;
+  for (uint8_t t = 0; t < THREADS; t++)
+  {
+    threads.emplace_back([&service, &readings, t] {
+      for (uint8_t i = t; i < SENSORS; i += THREADS)
+      {
+        readings[i] = service.measure(addresses[i]);
+      }
+    });
+  }
+  for (std::thread &thread : threads)
+  {
+    thread.join();
+  }
+  waitPending(service, SENSORS);
+  uint32_t conversions = OneWireSim::getConversions();
+  gate.unlock();
+  CHECK(blocker.get().result == gbj_ds18b20::SUCCESS);
+  for (uint8_t i = 0; i < SENSORS; i++)
+  {
+    Reading reading = readings[i].get();
+    CHECK(reading.result == gbj_ds18b20::SUCCESS);
+    CHECK(reading.temperature == temperature(i));
+  }
+  CHECK(OneWireSim::getConversions() - conversions == 1);
+}
+
+void testMeasureSingle(gbj_ds18b20_service &service)
+{
+  uint32_t conversions = OneWireSim::getConversions();
+  Reading reading = service.measure(addresses[SENSORS - 1]).get();
+  CHECK(reading.result == gbj_ds18b20::SUCCESS);
+  CHECK(reading.temperature == temperature(SENSORS - 1));
+  CHECK(OneWireSim::getConversions() - conversions == 1);
+}
+
+void testFailure(gbj_ds18b20_service &service)
+{
+  // Sensor not on the bus leaves no values of recent sensor in its reading
+  gbj_ds18b20::Address address;
+  memcpy(address, addresses[0], gbj_ds18b20::ADDRESS_LEN);
+  address[1] = 0xFF;
+  address[gbj_ds18b20::ADDRESS_LEN - 1] = gbj_ds18b20_crc::crc8(address, 7);
+  Reading reading = service.read(address).get();
+  CHECK(reading.result != gbj_ds18b20::SUCCESS);
+  CHECK(reading.temperature == 0);
+  CHECK(reading.resolution == 0);
+  CHECK(reading.alarmHigh == 0);
+}
+
+void testConfigure(gbj_ds18b20_service &service)
+{
+  std::vector<std::future<Reading> > readings(SENSORS);
+  std::vector<std::thread> threads;
+  for (uint8_t t = 0; t < THREADS; t++)
+  {
+    threads.emplace_back([&service, &readings, t] {
+      for (uint8_t i = t; i < SENSORS; i += THREADS)
+      {
+        readings[i] =
+          service.configure(addresses[i], -i, 30 + i, 9 + i % 4);
+      }
+    });
+  }
+  for (std::thread &thread : threads)
+  {
+    thread.join();
+  }
+  for (uint8_t i = 0; i < SENSORS; i++)
+  {
+    Reading reading = readings[i].get();
+    CHECK(reading.result == gbj_ds18b20::SUCCESS);
+    CHECK(reading.alarmLow == -i);
+    CHECK(reading.alarmHigh == 30 + i);
+    CHECK(reading.resolution == 9 + i % 4);
+  }
+  // Configuration is persistent
+  for (uint8_t i = 0; i < SENSORS; i++)
+  {
+    Reading reading = service.read(addresses[i]).get();
+    CHECK(reading.alarmHigh == 30 + i);
+    CHECK(reading.resolution == 9 + i % 4);
+  }
+}
+
+int main()
+{
+  OneWireSim::begin(SENSORS);
+  gbj_ds18b20 ds = gbj_ds18b20(PIN_ONEWIRE);
+  CHECK(collectAddresses(ds, addresses, SENSORS) == SENSORS);
+  OneWireSim::setResetHook(resetHook);
+  {
+    gbj_ds18b20_service service(ds);
+    testMeasureMerged(service);
+    testMeasureSingle(service);
+    testFailure(service);
+    testConfigure(service);
+  }
+  OneWireSim::setResetHook(0);
+  return report();
+}
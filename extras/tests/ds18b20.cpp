@@ -40,11 +40,71 @@ void test_setup_crc(void)
                          ds.crc8(address, ds.ADDRESS_LEN - 1));
 }
 
+void test_setup_crc_table(void)
+{
+  TEST_ASSERT_EQUAL_HEX8(ds.crc8(address, ds.ADDRESS_LEN - 1),
+                         gbj_ds18b20_crc::crc8(address, ds.ADDRESS_LEN - 1));
+  TEST_ASSERT_TRUE(gbj_ds18b20_crc::isValid(address, ds.ADDRESS_LEN));
+}
+
+void test_setup_crc_batch(void)
+{
+  gbj_ds18b20::Address frames[5];
+  bool valid[5];
+  for (uint8_t i = 0; i < 5; i++)
+  {
+    memcpy(frames[i], address, ds.ADDRESS_LEN);
+  }
+  frames[4][1] ^= 0x01;
+  TEST_ASSERT_EQUAL_UINT16(
+    4, gbj_ds18b20_crc::validate(frames[0], ds.ADDRESS_LEN, 5, valid));
+  TEST_ASSERT_TRUE(valid[3]);
+  TEST_ASSERT_FALSE(valid[4]);
+}
+
+void test_setup_histogram_percentile(void)
+{
+  gbj_ds18b20_histogram histogram = gbj_ds18b20_histogram(160);
+  for (uint8_t i = 0; i < 100; i++)
+  {
+    histogram.record(i < 99 ? 25 : 155);
+  }
+  TEST_ASSERT_EQUAL_UINT32(100, histogram.getSamples());
+  TEST_ASSERT_EQUAL_UINT16(30, histogram.getPercentile(99));
+  TEST_ASSERT_EQUAL_UINT16(160, histogram.getPercentile(100));
+}
+
+void test_setup_histogram_overflow(void)
+{
+  gbj_ds18b20_histogram histogram = gbj_ds18b20_histogram(160);
+  for (uint32_t i = 0; i < 0x10000; i++)
+  {
+    histogram.record(5);
+  }
+  TEST_ASSERT_EQUAL_UINT16(0x8000, histogram.getCount(0));
+  TEST_ASSERT_EQUAL_UINT32(0x8000, histogram.getSamples());
+}
+
 void test_bus_sensors(void)
 {
   TEST_ASSERT_TRUE(ds.getSensors() >= 1);
 }
 
+void test_bus_read_all(void)
+{
+  gbj_ds18b20::Address addresses[1];
+  int16_t temperatures[1];
+  gbj_ds18b20::ResultCodes statuses[1];
+  gbj_ds18b20::Snapshot snapshot = {
+    addresses, temperatures, NULL, statuses, 1, 0, 0
+  };
+  TEST_ASSERT_EQUAL_UINT8(ds.SUCCESS, ds.readAll(snapshot));
+  TEST_ASSERT_EQUAL_UINT8(1, snapshot.count);
+  TEST_ASSERT_EQUAL_UINT8(ds.SUCCESS, statuses[0]);
+  TEST_ASSERT_FLOAT_WITHIN(
+    tempDelta, tempRoom, gbj_ds18b20::calcTemperature(temperatures[0]));
+}
+
 void test_device_measure(void)
 {
   TEST_ASSERT_EQUAL_UINT8_MESSAGE(ds.SUCCESS,
@@ -178,8 +238,13 @@ void setup()
 
   RUN_TEST(test_setup_familycode);
   RUN_TEST(test_setup_crc);
+  RUN_TEST(test_setup_crc_table);
+  RUN_TEST(test_setup_crc_batch);
+  RUN_TEST(test_setup_histogram_percentile);
+  RUN_TEST(test_setup_histogram_overflow);
 
   RUN_TEST(test_bus_sensors);
+  RUN_TEST(test_bus_read_all);
 
   RUN_TEST(test_device_measure);
   RUN_TEST(test_device_familycode);
@@ -1,5 +1,9 @@
 #include "gbj_ds18b20.h"
 
+const uint8_t gbj_ds18b20::Bus::tempBits[4] = { 9, 10, 11, 12 };
+const uint8_t gbj_ds18b20::Bus::tempMask[4] = { 0xF8, 0xFC, 0xFE, 0xFF };
+constexpr uint16_t gbj_ds18b20::Bus::tempMillis[4];
+
 gbj_ds18b20::ResultCodes gbj_ds18b20::powering()
 {
   setLastResult();
@@ -16,9 +20,10 @@ gbj_ds18b20::ResultCodes gbj_ds18b20::devices()
   // Count all active devices on the bus
   bus_.devices = 0;
   bus_.sensors = 0;
+  bus_.resolution = 0;
   while (search(rom_.buffer))
   {
-    if (rom_.address.crc != crc8(rom_.buffer, Params::ADDRESS_LEN - 1))
+    if (!gbj_ds18b20_crc::isValid(rom_.buffer, Params::ADDRESS_LEN))
     {
       return setLastResult(ResultCodes::ERROR_CRC_ADDRESS);
     }
@@ -44,7 +49,6 @@ gbj_ds18b20::ResultCodes gbj_ds18b20::devices()
 
 gbj_ds18b20::ResultCodes gbj_ds18b20::sensors()
 {
-  static uint8_t iterations;
   setLastResult();
   while (search(rom_.buffer))
   {
@@ -54,11 +58,11 @@ gbj_ds18b20::ResultCodes gbj_ds18b20::sensors()
     }
     if (isSuccess(readScratchpad()))
     {
-      iterations++;
+      status_.iterations++;
     }
     return getLastResult();
   }
-  if (iterations > 0)
+  if (status_.iterations > 0)
   {
     setLastResult(ResultCodes::END_OF_LIST);
   }
@@ -66,15 +70,14 @@ gbj_ds18b20::ResultCodes gbj_ds18b20::sensors()
   {
     setLastResult(ResultCodes::ERROR_NO_SENSOR);
   }
-  bus_.sensors = iterations;
-  iterations = 0;
+  bus_.sensors = status_.iterations;
+  status_.iterations = 0;
   reset_search();
   return getLastResult();
 }
 
 gbj_ds18b20::ResultCodes gbj_ds18b20::alarms()
 {
-  static uint8_t iterations;
   // Conditional search
   while (search(rom_.buffer, false))
   {
@@ -84,7 +87,7 @@ gbj_ds18b20::ResultCodes gbj_ds18b20::alarms()
     }
     if (isSuccess(readScratchpad()))
     {
-      iterations++;
+      status_.iterations++;
       // Alarm low
       if (getTemperature() <= getAlarmLow())
       {
@@ -106,7 +109,7 @@ gbj_ds18b20::ResultCodes gbj_ds18b20::alarms()
     }
     return getLastResult();
   }
-  if (iterations)
+  if (status_.iterations)
   {
     setLastResult(ResultCodes::END_OF_LIST);
   }
@@ -114,7 +117,7 @@ gbj_ds18b20::ResultCodes gbj_ds18b20::alarms()
   {
     setLastResult(ResultCodes::ERROR_NO_ALARM);
   }
-  iterations = 0;
+  status_.iterations = 0;
   reset_search();
   return getLastResult();
 }
@@ -133,8 +136,7 @@ gbj_ds18b20::ResultCodes gbj_ds18b20::readScratchpad()
     return setLastResult(ResultCodes::ERROR_NO_DEVICE);
   }
   // Check scratchpad CRC
-  if (memory_.scratchpad.crc !=
-      crc8(memory_.buffer, Params::SCRATCHPAD_LEN - 1))
+  if (!gbj_ds18b20_crc::isValid(memory_.buffer, Params::SCRATCHPAD_LEN))
   {
     return setLastResult(ResultCodes::ERROR_CRC_SCRATCHPAD);
   }
@@ -155,6 +157,8 @@ gbj_ds18b20::ResultCodes gbj_ds18b20::writeScratchpad()
   {
     return getLastResult();
   }
+  // Keep bulk conversion waiting for the slowest sensor
+  bus_.resolution = max(bus_.resolution, getResolution());
   // Copy scratchpad to EEPROM
   select(rom_.buffer);
   write(CommandsFnc::COPY_SCRATCHPAD);
@@ -172,7 +176,84 @@ gbj_ds18b20::ResultCodes gbj_ds18b20::conversion()
   reset();
   skip();
   write(CommandsFnc::CONVERT_T, isPowerParasite());
-  return conversionWait();
+  // Wait for the slowest sensor on the bus
+  conversionWait(bus_.resolution);
+#if defined(GBJ_DS18B20_CONV_STATS)
+  if (convStats_ && isSuccess() && status_.convElapsed)
+  {
+    convStats_->histograms[bus_.resolution].record(status_.convElapsed);
+  }
+#endif
+  return getLastResult();
+}
+
+gbj_ds18b20::ResultCodes gbj_ds18b20::conversionStart()
+{
+  setLastResult();
+  reset();
+  skip();
+  write(CommandsFnc::CONVERT_T, isPowerParasite());
+  status_.tsConv = millis();
+  status_.convMillis = isPowerParasite() ? getConvWaitMillis(bus_.resolution)
+                                         : bus_.tempMillis[bus_.resolution];
+#if defined(GBJ_DS18B20_CONV_STATS)
+  status_.convResolution = bus_.resolution;
+#endif
+  return getLastResult();
+}
+
+gbj_ds18b20::ResultCodes gbj_ds18b20::conversionStart(const Address address,
+                                                      uint8_t resolutionBits)
+{
+  if (isError(cpyRom(address)))
+  {
+    return getLastResult();
+  }
+  // Resolution of the individual sensor might not be known yet
+  uint8_t resolution = bus_.resolution;
+  if (resolutionBits)
+  {
+    resolution = constrain(resolutionBits, bus_.tempBits[0], bus_.tempBits[3]) -
+                 bus_.tempBits[0];
+  }
+  reset();
+  select(rom_.buffer);
+  write(CommandsFnc::CONVERT_T, isPowerParasite());
+  status_.tsConv = millis();
+  status_.convMillis = isPowerParasite() ? getConvWaitMillis(resolution)
+                                         : bus_.tempMillis[resolution];
+#if defined(GBJ_DS18B20_CONV_STATS)
+  status_.convResolution = resolutionBits ? resolution : -1;
+#endif
+  return getLastResult();
+}
+
+bool gbj_ds18b20::isConversionDone()
+{
+  uint32_t elapsed = millis() - status_.tsConv;
+  bool timeout = elapsed > status_.convMillis;
+  if (isPowerParasite())
+  {
+    return timeout;
+  }
+  // Read time slot
+  if (read_bit())
+  {
+#if defined(GBJ_DS18B20_CONV_STATS)
+    // Record only the first detection of the end of conversion
+    if (convStats_ && status_.convResolution >= 0)
+    {
+      convStats_->histograms[status_.convResolution].record(elapsed);
+    }
+    status_.convResolution = -1;
+#endif
+    return true;
+  }
+  if (timeout)
+  {
+    setLastResult(ResultCodes::ERROR_CONVERSION);
+  }
+  return timeout;
 }
 
 gbj_ds18b20::ResultCodes gbj_ds18b20::measureTemperature(const Address address)
@@ -184,20 +265,89 @@ gbj_ds18b20::ResultCodes gbj_ds18b20::measureTemperature(const Address address)
   reset();
   select(rom_.buffer);
   write(CommandsFnc::CONVERT_T, isPowerParasite());
-  if (isSuccess(conversionWait()))
+  // Resolution of the sensor is not known before reading its scratchpad
+  if (isSuccess(conversionWait(bus_.resolution)))
   {
     readScratchpad();
   }
+#if defined(GBJ_DS18B20_CONV_STATS)
+  if (convStats_ && isSuccess() && status_.convElapsed)
+  {
+    convStats_->histograms[getResolution()].record(status_.convElapsed);
+  }
+#endif
+  return getLastResult();
+}
+
+gbj_ds18b20::ResultCodes gbj_ds18b20::measureTemperature(
+  const Address address,
+  gbj_ds18b20_histogram &histogram)
+{
+  // Conversion time is known only with the macro GBJ_DS18B20_CONV_STATS
+  if (isSuccess(measureTemperature(address)) && status_.convElapsed)
+  {
+    histogram.record(status_.convElapsed);
+  }
   return getLastResult();
 }
 
+gbj_ds18b20::ResultCodes gbj_ds18b20::readSensor(const Address address)
+{
+  if (isError(cpyRom(address)))
+  {
+    return getLastResult();
+  }
+  return readScratchpad();
+}
+
+gbj_ds18b20::ResultCodes gbj_ds18b20::readAll(Snapshot &snapshot)
+{
+  snapshot.count = 0;
+  conversion();
+  snapshot.timestamp = millis();
+  if (isError())
+  {
+    return getLastResult();
+  }
+  while (snapshot.count < snapshot.capacity && search(rom_.buffer))
+  {
+    if (getFamilyCode() != Params::FAMILY_CODE)
+    {
+      continue;
+    }
+    uint8_t i = snapshot.count++;
+    ResultCodes result = readScratchpad();
+    if (snapshot.addresses)
+    {
+      cpyAddress(snapshot.addresses[i]);
+    }
+    if (snapshot.temperatures)
+    {
+      snapshot.temperatures[i] = getTemperatureRaw();
+    }
+    if (snapshot.resolutions)
+    {
+      snapshot.resolutions[i] = getResolutionBits();
+    }
+    if (snapshot.statuses)
+    {
+      snapshot.statuses[i] = result;
+    }
+  }
+  reset_search();
+  if (snapshot.count == 0)
+  {
+    return setLastResult(ResultCodes::ERROR_NO_SENSOR);
+  }
+  return setLastResult();
+}
+
 gbj_ds18b20::ResultCodes gbj_ds18b20::cpyRom(const Address address)
 {
   setLastResult();
   resetRom();
   // Check ROM CRC
-  if (address[Params::ADDRESS_LEN - 1] !=
-      crc8(address, Params::ADDRESS_LEN - 1))
+  if (!gbj_ds18b20_crc::isValid(address, Params::ADDRESS_LEN))
   {
     return setLastResult(ResultCodes::ERROR_CRC_ADDRESS);
   }
@@ -206,26 +356,229 @@ gbj_ds18b20::ResultCodes gbj_ds18b20::cpyRom(const Address address)
   return getLastResult();
 }
 
-gbj_ds18b20::ResultCodes gbj_ds18b20::conversionWait()
+gbj_ds18b20::ResultCodes gbj_ds18b20::conversionWait(uint8_t resolution)
 {
+  uint16_t convMillis = bus_.tempMillis[resolution];
   setLastResult();
+#if defined(GBJ_DS18B20_CONV_STATS)
+  status_.convElapsed = 0;
+#endif
   if (bus_.powerExternal)
   {
     // Read time slot
     uint32_t tsConv = millis();
     while (!read_bit())
     {
-      if (millis() - tsConv > getConvMillis())
+      if (millis() - tsConv > convMillis)
       {
         setLastResult(ResultCodes::ERROR_CONVERSION);
         break;
       }
       continue;
     }
+#if defined(GBJ_DS18B20_CONV_STATS)
+    // At least 1 ms for distinguishing from unknown time
+    status_.convElapsed = max(millis() - tsConv, 1UL);
+#endif
   }
   else
   {
-    delay(getConvMillis()); // Waiting conversion time period
+    // Waiting conversion time period
+    delay(getConvWaitMillis(resolution));
   }
   return getLastResult();
 }
+
+uint16_t gbj_ds18b20::getConvWaitMillis(uint8_t resolution)
+{
+  resolution &= 0b11;
+  uint16_t convMillis = bus_.tempMillis[resolution];
+#if defined(GBJ_DS18B20_CONV_STATS)
+  if (convStats_ && convStats_->calibrated &&
+      convStats_->histograms[resolution].getSamples() >=
+        convStats_->samplesMin)
+  {
+    uint16_t calibMillis =
+      convStats_->histograms[resolution].getPercentile(99) +
+      convStats_->marginMillis;
+    convMillis = min(convMillis, calibMillis);
+  }
+#endif
+  return convMillis;
+}
+
+#if defined(GBJ_DS18B20_TRACE)
+uint8_t gbj_ds18b20::reset()
+{
+  uint8_t flags;
+  if (isReplaying())
+  {
+    trace_->get(gbj_ds18b20_trace::OP_RESET, flags);
+    return flags;
+  }
+  flags = OneWire::reset();
+  if (isRecording())
+  {
+    trace_->put(gbj_ds18b20_trace::OP_RESET, flags);
+  }
+  return flags;
+}
+
+void gbj_ds18b20::select(const uint8_t rom[8])
+{
+  uint8_t flags;
+  if (isReplaying())
+  {
+    Address address;
+    // Selected address should match the recorded one
+    if (trace_->get(gbj_ds18b20_trace::OP_SELECT,
+                    flags,
+                    address,
+                    Params::ADDRESS_LEN) &&
+        memcmp(address, rom, Params::ADDRESS_LEN) != 0)
+    {
+      trace_->diverge();
+    }
+    return;
+  }
+  OneWire::select(rom);
+  if (isRecording())
+  {
+    trace_->put(gbj_ds18b20_trace::OP_SELECT, 0, rom, Params::ADDRESS_LEN);
+  }
+}
+
+void gbj_ds18b20::skip()
+{
+  uint8_t flags;
+  if (isReplaying())
+  {
+    trace_->get(gbj_ds18b20_trace::OP_SKIP, flags);
+    return;
+  }
+  OneWire::skip();
+  if (isRecording())
+  {
+    trace_->put(gbj_ds18b20_trace::OP_SKIP);
+  }
+}
+
+void gbj_ds18b20::write(uint8_t v, uint8_t power)
+{
+  uint8_t flags;
+  if (isReplaying())
+  {
+    uint8_t value;
+    // Written byte should match the recorded one
+    if (trace_->get(gbj_ds18b20_trace::OP_WRITE, flags, &value, 1) &&
+        value != v)
+    {
+      trace_->diverge();
+    }
+    return;
+  }
+  OneWire::write(v, power);
+  if (isRecording())
+  {
+    trace_->put(gbj_ds18b20_trace::OP_WRITE, power ? 1 : 0, &v, 1);
+  }
+}
+
+void gbj_ds18b20::read_bytes(uint8_t *buf, uint16_t count)
+{
+  uint8_t flags;
+  if (isReplaying())
+  {
+    // Number of read bytes should match the recorded one
+    if (trace_->get(gbj_ds18b20_trace::OP_READ_BYTES, flags, buf, count) &&
+        trace_->getPayloadLen() != count)
+    {
+      trace_->diverge();
+    }
+    return;
+  }
+  OneWire::read_bytes(buf, count);
+  if (isRecording())
+  {
+    trace_->put(gbj_ds18b20_trace::OP_READ_BYTES, 0, buf, count);
+  }
+}
+
+uint8_t gbj_ds18b20::read_bit()
+{
+  uint8_t flags;
+  if (isReplaying())
+  {
+    // Finished conversion after end of replaying for avoiding endless wait
+    return trace_->get(gbj_ds18b20_trace::OP_READ_BIT, flags) ? flags : 1;
+  }
+  flags = OneWire::read_bit();
+  if (isRecording())
+  {
+    trace_->put(gbj_ds18b20_trace::OP_READ_BIT, flags);
+  }
+  return flags;
+}
+
+bool gbj_ds18b20::search(uint8_t *newAddr, bool search_mode)
+{
+  uint8_t flags;
+  if (isReplaying())
+  {
+    if (!trace_->get(gbj_ds18b20_trace::OP_SEARCH,
+                     flags,
+                     newAddr,
+                     Params::ADDRESS_LEN))
+    {
+      return false;
+    }
+    // Search mode should match the recorded one
+    if (bool(flags & 2) != search_mode)
+    {
+      trace_->diverge();
+      return false;
+    }
+    return flags & 1;
+  }
+  bool result = OneWire::search(newAddr, search_mode);
+  if (isRecording())
+  {
+    trace_->put(gbj_ds18b20_trace::OP_SEARCH,
+                (result ? 1 : 0) | (search_mode ? 2 : 0),
+                newAddr,
+                result ? Params::ADDRESS_LEN : 0);
+  }
+  return result;
+}
+
+void gbj_ds18b20::reset_search()
+{
+  uint8_t flags;
+  if (isReplaying())
+  {
+    trace_->get(gbj_ds18b20_trace::OP_RESET_SEARCH, flags);
+    return;
+  }
+  OneWire::reset_search();
+  if (isRecording())
+  {
+    trace_->put(gbj_ds18b20_trace::OP_RESET_SEARCH);
+  }
+}
+#else
+// Without tracing bus transactions are just passed to OneWire
+uint8_t gbj_ds18b20::reset() { return OneWire::reset(); }
+void gbj_ds18b20::select(const uint8_t rom[8]) { OneWire::select(rom); }
+void gbj_ds18b20::skip() { OneWire::skip(); }
+void gbj_ds18b20::write(uint8_t v, uint8_t power) { OneWire::write(v, power); }
+void gbj_ds18b20::read_bytes(uint8_t *buf, uint16_t count)
+{
+  OneWire::read_bytes(buf, count);
+}
+uint8_t gbj_ds18b20::read_bit() { return OneWire::read_bit(); }
+bool gbj_ds18b20::search(uint8_t *newAddr, bool search_mode)
+{
+  return OneWire::search(newAddr, search_mode);
+}
+void gbj_ds18b20::reset_search() { OneWire::reset_search(); }
+#endif
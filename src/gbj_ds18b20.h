@@ -16,6 +16,14 @@
     in a loop, so that they need not to be identified by an address in advance.
     Thus, all getters and setters are valid for currently selected sensor
     in a loop.
+  - Defining the macro GBJ_DS18B20_CONV_STATS as a global build flag enables
+    recording of measured conversion times to attached statistics and
+    calibrated waiting for conversion in parasitic power mode. The class has
+    the same layout without it, but the library source then ignores attached
+    statistics.
+  - Defining the macro GBJ_DS18B20_TRACE as a global build flag enables
+    recording and replaying of bus transactions. The class has the same
+    layout without it, but the library source then ignores attached traces.
 
   LICENSE:
   This program is free software; you can redistribute it and/or modify
@@ -36,6 +44,9 @@
 #elif defined(ESP8266) || defined(ESP32)
   #include <Arduino.h>
 #endif
+#include "gbj_ds18b20_crc.h"
+#include "gbj_ds18b20_histogram.h"
+#include "gbj_ds18b20_trace.h"
 #include <OneWire.h>
 
 class gbj_ds18b20 : public OneWire
@@ -53,6 +64,13 @@ public:
     ERROR_ALARM_LOW,
     ERROR_ALARM_HIGH,
     ERROR_CONVERSION,
+    ERROR_POWER_MODE,
+  };
+
+  enum PowerModes : uint8_t
+  {
+    POWER_EXTERNAL,
+    POWER_PARASITE,
   };
 
   enum Params : uint8_t
@@ -68,6 +86,68 @@ public:
   typedef uint8_t Scratchpad[Params::SCRATCHPAD_LEN];
   typedef void Handler();
 
+  /*
+    Snapshot of all sensors on the bus
+
+    DESCRIPTION:
+    The structure references caller-owned arrays, which are filled by the
+    method readAll() with values of the same sensor at the same index.
+    - Temperatures are raw, i.e., in sixteenths of centigrade with bits
+      masked according to the sensor's resolution.
+    - Resolutions are in bits.
+    - Any array pointer may be null, if the corresponding value is not needed.
+    - Arrays should have at least capacity items.
+  */
+  struct Snapshot
+  {
+    Address *addresses;
+    int16_t *temperatures;
+    uint8_t *resolutions;
+    ResultCodes *statuses;
+    // Number of items in each array
+    uint8_t capacity;
+    // Number of sensors read in recent cycle
+    uint8_t count;
+    // Timestamp of recent conversion end in milliseconds
+    uint32_t timestamp;
+  };
+
+  /*
+    Statistics of conversion times
+
+    DESCRIPTION:
+    The structure is owned by a sketch and attached to the bus by the setter
+    setConvStats(). The library records to it and waits calibrated by it only
+    if its source is built with the macro GBJ_DS18B20_CONV_STATS.
+    - Histograms are indexed by the resolution code 0 ~ 3 and cover the
+      maximal conversion time of it according to datasheet.
+    - In calibrated mode the library waits for conversion in parasitic power
+      mode for the 99th percentile of the histogram plus the margin, if the
+      histogram contains at least minimal number of samples.
+  */
+  struct ConvStats
+  {
+    // Minimal number of samples for calibrated waiting
+    static const uint16_t samplesMin = 32;
+    gbj_ds18b20_histogram histograms[4];
+    bool calibrated;
+    uint16_t marginMillis;
+
+    ConvStats()
+      : calibrated(false)
+      , marginMillis(10)
+    {
+      for (uint8_t i = 0; i < sizeof(histograms) / sizeof(histograms[0]); i++)
+      {
+        histograms[i].begin(getConvMaxMillis(i));
+      }
+    }
+    inline gbj_ds18b20_histogram &getHistogram(uint8_t resolution)
+    {
+      return histograms[resolution & 0b11];
+    }
+  };
+
   /*
     Constructor
 
@@ -93,16 +173,31 @@ public:
       - Default value: 0
       - Limited range: system address range
 
+    trace - Pointer to the trace of bus transactions, which is recording or
+      replaying already at construction. It is ignored unless the library
+      is built with the macro GBJ_DS18B20_TRACE.
+      - Data type: gbj_ds18b20_trace
+      - Default value: 0
+      - Limited range: system address range
+
     RETURN: object
   */
   gbj_ds18b20(uint8_t pinBus,
               Handler *alarmHandlerLow = 0,
-              Handler *alarmHandlerHigh = 0)
+              Handler *alarmHandlerHigh = 0,
+              gbj_ds18b20_trace *trace = 0)
     : OneWire(pinBus)
   {
+    trace_ = trace;
     bus_.pinBus = pinBus;
     bus_.alarmHandlerLow = alarmHandlerLow;
     bus_.alarmHandlerHigh = alarmHandlerHigh;
+    status_.iterations = 0;
+    status_.tsConv = 0;
+    status_.convMillis = 0;
+    status_.convElapsed = 0;
+    status_.convResolution = -1;
+    convStats_ = 0;
     if (isError(powering()))
     {
       return;
@@ -167,6 +262,34 @@ public:
   */
   ResultCodes conversion();
 
+  /*
+    Start temperature conversion without waiting.
+
+    DESCRIPTION:
+    The method initiates measurement conversion of all sensors on the
+    one-wire bus at once or of the particular sensor with provided address
+    and returns immediately. The end of the conversion should be detected
+    by the getter isConversionDone() before any other communication on the bus.
+
+    PARAMETERS:
+    address - Temperature sensor address.
+      - Data type: array of non-negative integers
+      - Default value: none
+      - Limited range: 0 ~ 255[8]
+
+    resolutionBits - Known resolution of the sensor in bits determining
+      the conversion time. If it is zero, the highest resolution on the bus
+      is used.
+      - Data type: non-negative integer
+      - Default value: 0
+      - Limited range: 0, 9 ~ 12
+
+    RETURN: Result code.
+  */
+  ResultCodes conversionStart();
+  ResultCodes conversionStart(const Address address,
+                              uint8_t resolutionBits = 0);
+
   /*
     Execute temperature measurement by individual sensor.
 
@@ -185,6 +308,73 @@ public:
   */
   ResultCodes measureTemperature(const Address address);
 
+  /*
+    Execute temperature measurement by individual sensor with statistics.
+
+    DESCRIPTION:
+    The method measures temperature as the method without histogram
+    and additionally counts the measured conversion time in the provided
+    histogram, e.g., kept for that particular sensor.
+    - The conversion time is measured only in external power mode and only
+      if the library is built with the macro GBJ_DS18B20_CONV_STATS.
+
+    PARAMETERS:
+    address - Temperature sensor address.
+      - Data type: array of non-negative integers
+      - Default value: none
+      - Limited range: 0 ~ 255[8]
+
+    histogram - Histogram of conversion times of the sensor.
+      - Data type: gbj_ds18b20_histogram
+      - Default value: none
+      - Limited range: none
+
+    RETURN: Result code.
+  */
+  ResultCodes measureTemperature(const Address address,
+                                 gbj_ds18b20_histogram &histogram);
+
+  /*
+    Read all sensors on the bus in one cycle.
+
+    DESCRIPTION:
+    The method executes bulk temperature conversion and then reads scratchpad
+    of all sensors on the bus one by one into provided snapshot arrays.
+    - The number of sensors read and the timestamp of the conversion are
+      stored in the snapshot. At failed conversion the count is zero and the
+      timestamp marks the failure.
+    - Sensors above snapshot capacity are ignored.
+    - Sensor with failed scratchpad reading is still put to the snapshot with
+      corresponding error code in the statuses array.
+
+    PARAMETERS:
+    snapshot - Structure referencing arrays for sensors' values.
+      - Data type: Snapshot
+      - Default value: none
+      - Limited range: none
+
+    RETURN: Result code.
+  */
+  ResultCodes readAll(Snapshot &snapshot);
+
+  /*
+    Read individual sensor.
+
+    DESCRIPTION:
+    The method selects the particular sensor with provided address on the
+    one-wire bus and reads its scratchpad for further processing by getters
+    and setters without initiating a conversion.
+
+    PARAMETERS:
+    address - Temperature sensor address.
+      - Data type: array of non-negative integers
+      - Default value: none
+      - Limited range: 0 ~ 255[8]
+
+    RETURN: Result code.
+  */
+  ResultCodes readSensor(const Address address);
+
   // Public setters
   inline ResultCodes setLastResult(ResultCodes result = ResultCodes::SUCCESS)
   {
@@ -195,7 +385,7 @@ public:
     resolution = constrain(
       resolution,
       bus_.tempBits[0],
-      bus_.tempBits[sizeof(bus_.tempBits) / sizeof(bus_.tempBits[0])]);
+      bus_.tempBits[sizeof(bus_.tempBits) / sizeof(bus_.tempBits[0]) - 1]);
     memory_.scratchpad.config = 0x1F;
     for (uint8_t i = 0; i < sizeof(bus_.tempBits) / sizeof(bus_.tempBits[0]);
          i++)
@@ -223,6 +413,22 @@ public:
     cacheAlarmHigh(getAlarmHighIni());
   }
   inline ResultCodes setCache() { return writeScratchpad(); }
+  inline void setTrace(gbj_ds18b20_trace *trace = 0) { trace_ = trace; }
+
+  // Bus transactions hiding ones of OneWire for recording and replaying,
+  // declared regardless of the macro GBJ_DS18B20_TRACE for stable layout
+  uint8_t reset();
+  void select(const uint8_t rom[8]);
+  void skip();
+  void write(uint8_t v, uint8_t power = 0);
+  void read_bytes(uint8_t *buf, uint16_t count);
+  uint8_t read_bit();
+  bool search(uint8_t *newAddr, bool search_mode = true);
+  void reset_search();
+  inline void setConvStats(ConvStats *convStats = 0)
+  {
+    convStats_ = convStats;
+  }
 
   // Public getters
   inline ResultCodes getLastResult() { return status_.lastResult; }
@@ -302,13 +508,29 @@ public:
     uint8_t resolution = memory_.scratchpad.config >> ConfigRegBit::R0;
     return resolution & 0b11;
   }
-  float getTemperature()
+  inline int16_t getTemperatureRaw()
   {
     int16_t temp = memory_.scratchpad.temp_msb << 8;
     temp |= memory_.scratchpad.temp_lsb & bus_.tempMask[getResolution()];
-    return (float)temp / 16.0;
+    return temp;
+  }
+  inline float getTemperature() { return calcTemperature(getTemperatureRaw()); }
+  static inline float calcTemperature(int16_t temperatureRaw)
+  {
+    return (float)temperatureRaw / 16.0;
   }
   inline uint16_t getConvMillis() { return bus_.tempMillis[getResolution()]; }
+  inline uint8_t getResolutionBus() { return bus_.resolution; }
+  bool isConversionDone();
+  inline ConvStats *getConvStats() { return convStats_; }
+  // Time of waiting for conversion in parasitic power mode for resolution
+  // 0 ~ 3, higher bits are ignored
+  uint16_t getConvWaitMillis(uint8_t resolution);
+  // Maximal conversion time according to datasheet for resolution 0 ~ 3
+  static constexpr uint16_t getConvMaxMillis(uint8_t resolution)
+  {
+    return Bus::tempMillis[resolution & 0b11];
+  }
 
 private:
   enum ConfigRegBit : uint8_t
@@ -366,17 +588,13 @@ private:
 
   struct Bus
   {
+    // Static tables shared by all instances - defined in the source file
     // Resolutions in bits - Values { 0x1F, 0x3F, 0x5F, 0x7F }
-    uint8_t tempBits[4] = { 9, 10, 11, 12 };
+    static const uint8_t tempBits[4];
     // LSB bits masks
-    uint8_t tempMask[4] = { 0xF8, 0xFC, 0xFE, 0xFF };
-    // Maximal conversion times in milliseconds
-    uint16_t tempMillis[4] = {
-      94,
-      188,
-      375,
-      750
-    };
+    static const uint8_t tempMask[4];
+    // Maximal conversion times in milliseconds, shared at compile time
+    static constexpr uint16_t tempMillis[4] = { 94, 188, 375, 750 };
     uint8_t pinBus;
     // The highest resolution of all devices
     uint8_t resolution;
@@ -394,14 +612,29 @@ private:
   struct Status
   {
     ResultCodes lastResult;
+    // Number of sensors selected in recent searching loop
+    uint8_t iterations;
+    // Start and maximal duration of recent conversion in milliseconds
+    uint32_t tsConv;
+    uint16_t convMillis;
+    // Measured time of recent conversion in milliseconds, 0 if unknown
+    uint16_t convElapsed;
+    // Resolution of recent conversion, negative for individual sensor
+    int8_t convResolution;
   } status_;
 
+  gbj_ds18b20_trace *trace_;
+  inline bool isReplaying() { return trace_ && trace_->isReplaying(); }
+  inline bool isRecording() { return trace_ && trace_->isRecording(); }
+
+  ConvStats *convStats_;
+
   // Detect power mode
   ResultCodes powering();
   // Copy address to ROM buffer
   ResultCodes cpyRom(const Address address);
   inline void resetRom() { memset(rom_.buffer, 0, Params::ADDRESS_LEN); }
-  ResultCodes conversionWait();
+  ResultCodes conversionWait(uint8_t resolution);
   ResultCodes readScratchpad();
   ResultCodes writeScratchpad();
   inline void resetScratchpad()
@@ -0,0 +1,217 @@
+/*
+  NAME:
+  gbj_ds18b20_async
+
+  DESCRIPTION:
+  Awaitable interface to temperature sensors Dallas Semiconductor DS18B20
+  for toolchains supporting C++20 coroutines.
+  - The class gbj_ds18b20_async extends the class gbj_ds18b20 by methods
+    convertAsync() and readAsync(), which suspend a coroutine for the time
+    of a conversion instead of waiting for it.
+  - The class gbj_ds18b20_loop is the minimal scheduler, which resumes
+    suspended coroutines after the end of their conversions. Its method run()
+    should be called repeatedly, e.g., in the function loop() of a sketch.
+  - The class gbj_ds18b20_task is the return type of coroutines started by
+    a sketch, which run until their first suspension right at calling.
+  - Awaitables are built on the non-blocking methods conversionStart()
+    and isConversionDone() of the class gbj_ds18b20.
+  - Coroutines can drive multiple buses concurrently, but only one coroutine
+    should communicate on a particular bus at a time.
+
+  LICENSE:
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the license GNU GPL v3
+  http://www.gnu.org/licenses/gpl-3.0.html (related to original code) and MIT
+  License (MIT) for added code.
+
+  CREDENTIALS:
+  Author: Libor Gabaj
+  GitHub: https://github.com/mrkaleArduinoLib/gbj_ds18b20.git
+ */
+#ifndef GBJ_DS18B20_ASYNC_H
+#define GBJ_DS18B20_ASYNC_H
+
+#include "gbj_ds18b20.h"
+#if defined(__cpp_impl_coroutine)
+  #include <coroutine>
+  #include <exception>
+
+// Fire-and-forget coroutine, which destroys itself at the end
+struct gbj_ds18b20_task
+{
+  struct promise_type
+  {
+    gbj_ds18b20_task get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+class gbj_ds18b20_loop
+{
+public:
+  // Suspended coroutine linked in the list of the scheduler
+  struct Waiter
+  {
+    std::coroutine_handle<> handle;
+    gbj_ds18b20 *ds;
+    Waiter *next;
+  };
+
+  /*
+    Resume coroutines with finished conversions
+
+    DESCRIPTION:
+    The method checks all suspended coroutines once and resumes those,
+    whose conversion has finished.
+
+    PARAMETERS: None
+
+    RETURN: Number of still suspended coroutines.
+  */
+  uint8_t run()
+  {
+    uint8_t pending = 0;
+    Waiter **link = &head_;
+    while (*link)
+    {
+      Waiter *waiter = *link;
+      if (!waiter->ds->isConversionDone())
+      {
+        link = &waiter->next;
+        pending++;
+        continue;
+      }
+      // Unlink before resuming, because the waiter lives in the coroutine
+      *link = waiter->next;
+      waiter->handle.resume();
+    }
+    return pending;
+  }
+
+  // Public getters
+  inline bool isIdle() { return head_ == nullptr; }
+
+  // Register suspended coroutine
+  void suspend(Waiter &waiter)
+  {
+    waiter.next = head_;
+    head_ = &waiter;
+  }
+
+private:
+  Waiter *head_ = nullptr;
+};
+
+class gbj_ds18b20_async : public gbj_ds18b20
+{
+public:
+  /*
+    Constructor
+
+    DESCRIPTION:
+    Constructor creates the class instance object bound to the scheduler.
+
+    PARAMETERS:
+    scheduler - Scheduler resuming coroutines suspended on this bus.
+      - Data type: gbj_ds18b20_loop
+      - Default value: none
+      - Limited range: none
+
+    Other parameters are the same as for the class gbj_ds18b20.
+
+    RETURN: object
+  */
+  gbj_ds18b20_async(gbj_ds18b20_loop &scheduler,
+                    uint8_t pinBus,
+                    Handler *alarmHandlerLow = 0,
+                    Handler *alarmHandlerHigh = 0,
+                    gbj_ds18b20_trace *trace = 0)
+    : gbj_ds18b20(pinBus, alarmHandlerLow, alarmHandlerHigh, trace)
+    , scheduler_(scheduler)
+  {
+  }
+
+  // Awaitable conversion, optionally followed by reading a sensor
+  class Awaiter
+  {
+  public:
+    Awaiter(gbj_ds18b20_async &ds, const uint8_t *address)
+      : ds_(ds)
+      , read_(address != nullptr)
+    {
+      if (read_)
+      {
+        memcpy(address_, address, Params::ADDRESS_LEN);
+      }
+    }
+    bool await_ready()
+    {
+      ResultCodes result =
+        read_ ? ds_.conversionStart(address_) : ds_.conversionStart();
+      return result != ResultCodes::SUCCESS;
+    }
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+      waiter_.handle = handle;
+      waiter_.ds = &ds_;
+      ds_.scheduler_.suspend(waiter_);
+    }
+    ResultCodes await_resume()
+    {
+      if (read_ && ds_.isSuccess())
+      {
+        return ds_.readSensor(address_);
+      }
+      return ds_.getLastResult();
+    }
+
+  private:
+    gbj_ds18b20_async &ds_;
+    gbj_ds18b20_loop::Waiter waiter_;
+    Address address_;
+    bool read_;
+  };
+
+  /*
+    Awaitable bulk temperature conversion
+
+    DESCRIPTION:
+    The method initiates measurement conversion of all sensors on the bus
+    and suspends the awaiting coroutine until the end of the conversion.
+
+    PARAMETERS: None
+
+    RETURN: Awaitable with result code.
+  */
+  inline Awaiter convertAsync() { return Awaiter(*this, nullptr); }
+
+  /*
+    Awaitable temperature measurement by individual sensor
+
+    DESCRIPTION:
+    The method initiates measurement conversion of the particular sensor,
+    suspends the awaiting coroutine until the end of the conversion, and
+    reads the sensor's scratchpad for getters.
+
+    PARAMETERS:
+    address - Temperature sensor address.
+      - Data type: array of non-negative integers
+      - Default value: none
+      - Limited range: 0 ~ 255[8]
+
+    RETURN: Awaitable with result code.
+  */
+  inline Awaiter readAsync(const Address address)
+  {
+    return Awaiter(*this, address);
+  }
+
+private:
+  gbj_ds18b20_loop &scheduler_;
+};
+
+#endif
+#endif
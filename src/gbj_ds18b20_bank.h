@@ -0,0 +1,305 @@
+/*
+  NAME:
+  gbj_ds18b20_bank
+
+  DESCRIPTION:
+  Compile-time specialized bank of a fixed number of temperature sensors
+  Dallas Semiconductor DS18B20 on the one-wire bus.
+  - All sensors in the bank work with the same resolution and the one-wire bus
+    has the same power mode, both defined by template parameters, so that
+    conversion time, temperature masking, and parasite power branches are
+    resolved at compile time and no lookup tables are stored in RAM.
+  - Addresses of sensors are stored in the fixed-size array for N sensors,
+    which are detected by the constructor.
+  - The resolution of a sensor is written to its EEPROM at detection only if
+    it differs from the resolution of the bank. It is written to all sensors
+    on the bus including those above N, so that no sensor prolongs the bulk
+    conversion.
+  - Data types and result codes are shared with the class gbj_ds18b20.
+
+  LICENSE:
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the license GNU GPL v3
+  http://www.gnu.org/licenses/gpl-3.0.html (related to original code) and MIT
+  License (MIT) for added code.
+
+  CREDENTIALS:
+  Author: Libor Gabaj
+  GitHub: https://github.com/mrkaleArduinoLib/gbj_ds18b20.git
+ */
+#ifndef GBJ_DS18B20_BANK_H
+#define GBJ_DS18B20_BANK_H
+
+#include "gbj_ds18b20.h"
+
+template<uint8_t N,
+         uint8_t Resolution = 12,
+         gbj_ds18b20::PowerModes PowerMode = gbj_ds18b20::POWER_EXTERNAL>
+class gbj_ds18b20_bank : public OneWire
+{
+  static_assert(N > 0, "Bank should contain at least one sensor");
+  static_assert(Resolution >= 9 && Resolution <= 12,
+                "Resolution should be 9 to 12 bits");
+
+public:
+  typedef gbj_ds18b20::ResultCodes ResultCodes;
+  typedef gbj_ds18b20::Address Address;
+
+  /*
+    Constructor
+
+    DESCRIPTION:
+    Constructor creates the class instance object and detects up to N
+    temperature sensors on the bus.
+
+    PARAMETERS:
+    pinBus - Number of GPIO pin of the microcontroller managing one-wire bus.
+      - Data type: non-negative integer
+      - Default value: none
+      - Limited range: 0 ~ 255
+
+    RETURN: object
+  */
+  gbj_ds18b20_bank(uint8_t pinBus)
+    : OneWire(pinBus)
+  {
+    devices();
+  }
+
+  /*
+    Detect temperature sensors on the bus
+
+    DESCRIPTION:
+    The method stores addresses of up to N temperature sensors on the bus
+    and sets the bank's resolution to all sensors on the bus, even to those
+    above N, because the bulk conversion starts all of them.
+
+    PARAMETERS: None
+
+    RETURN: Result code. If the power mode of the bus differs from the bank's
+      one, the error code ERROR_POWER_MODE is returned and no sensor is
+      detected.
+  */
+  ResultCodes devices()
+  {
+    setLastResult();
+    sensors_ = 0;
+    // Polling a parasite bus would drop the strong pull-up during conversion
+    reset();
+    skip();
+    write(READ_POWER_SUPPLY);
+    if (read_bit() != isPowerExternal())
+    {
+      return setLastResult(gbj_ds18b20::ERROR_POWER_MODE);
+    }
+    Address address;
+    while (search(address))
+    {
+      if (!gbj_ds18b20_crc::isValid(address, gbj_ds18b20::ADDRESS_LEN))
+      {
+        reset_search();
+        return setLastResult(gbj_ds18b20::ERROR_CRC_ADDRESS);
+      }
+      if (address[0] != gbj_ds18b20::FAMILY_CODE)
+      {
+        continue;
+      }
+      if (isError(configure(address)))
+      {
+        reset_search();
+        return getLastResult();
+      }
+      if (sensors_ < N)
+      {
+        memcpy(addresses_[sensors_++], address, gbj_ds18b20::ADDRESS_LEN);
+      }
+    }
+    reset_search();
+    if (sensors_ == 0)
+    {
+      setLastResult(gbj_ds18b20::ERROR_NO_SENSOR);
+    }
+    return getLastResult();
+  }
+
+  /*
+    Measure temperature by all sensors of the bank
+
+    DESCRIPTION:
+    The method executes bulk temperature conversion, waits for its end, and
+    reads temperatures of all sensors of the bank for getters.
+
+    PARAMETERS: None
+
+    RETURN: Result code.
+  */
+  ResultCodes measure()
+  {
+    if (isError(conversion()))
+    {
+      return getLastResult();
+    }
+    for (uint8_t i = 0; i < sensors_; i++)
+    {
+      gbj_ds18b20::Scratchpad scratchpad;
+      if (isError(readScratchpad(addresses_[i], scratchpad)))
+      {
+        return getLastResult();
+      }
+      temperatures_[i] = scratchpad[1] << 8;
+      temperatures_[i] |= scratchpad[0] & MASK;
+    }
+    return getLastResult();
+  }
+
+  /*
+    Execute bulk temperature conversion.
+
+    DESCRIPTION:
+    The method initiates measurement conversion of all sensors on the
+    one-wire bus at once and waits for the compile-time conversion time.
+
+    PARAMETERS: None
+
+    RETURN: Result code.
+  */
+  ResultCodes conversion()
+  {
+    setLastResult();
+    reset();
+    skip();
+    write(CONVERT_T, isPowerParasite());
+    if (isPowerParasite())
+    {
+      delay(getConvMillis());
+    }
+    else
+    {
+      uint32_t tsConv = millis();
+      while (!read_bit())
+      {
+        if (millis() - tsConv > getConvMillis())
+        {
+          return setLastResult(gbj_ds18b20::ERROR_CONVERSION);
+        }
+      }
+    }
+    return getLastResult();
+  }
+
+  // Public setters
+  inline ResultCodes setLastResult(
+    ResultCodes result = gbj_ds18b20::SUCCESS)
+  {
+    return lastResult_ = result;
+  }
+
+  // Public getters
+  inline ResultCodes getLastResult() { return lastResult_; }
+  inline bool isSuccess() { return lastResult_ == gbj_ds18b20::SUCCESS; }
+  inline bool isSuccess(ResultCodes result)
+  {
+    setLastResult(result);
+    return isSuccess();
+  }
+  inline bool isError() { return !isSuccess(); }
+  inline bool isError(ResultCodes result)
+  {
+    setLastResult(result);
+    return isError();
+  }
+  inline uint8_t getSensors() { return sensors_; }
+  inline uint8_t *getAddressRef(uint8_t index) { return addresses_[index]; }
+  inline int16_t getTemperatureRaw(uint8_t index)
+  {
+    return temperatures_[index];
+  }
+  inline float getTemperature(uint8_t index)
+  {
+    return gbj_ds18b20::calcTemperature(temperatures_[index]);
+  }
+  static constexpr uint8_t getCapacity() { return N; }
+  static constexpr uint8_t getResolutionBits() { return Resolution; }
+  static constexpr uint16_t getConvMillis()
+  {
+    return gbj_ds18b20::getConvMaxMillis(Resolution - 9);
+  }
+  static constexpr bool isPowerParasite()
+  {
+    return PowerMode == gbj_ds18b20::POWER_PARASITE;
+  }
+  static constexpr bool isPowerExternal() { return !isPowerParasite(); }
+
+private:
+  enum Commands : uint8_t
+  {
+    CONVERT_T = 0x44,
+    WRITE_SCRATCHPAD = 0x4E,
+    READ_SCRATCHPAD = 0xBE,
+    COPY_SCRATCHPAD = 0x48,
+    READ_POWER_SUPPLY = 0xB4,
+  };
+
+  enum Layout : uint8_t
+  {
+    // Scratchpad positions
+    ALARM_HIGH = 2,
+    ALARM_LOW = 3,
+    CONFIG = 4,
+    // Compile-time configuration register and LSB mask
+    CONFIG_REG = 0x1F | ((Resolution - 9) << 5),
+    MASK = (0xFF << (12 - Resolution)) & 0xFF,
+  };
+
+  Address addresses_[N];
+  int16_t temperatures_[N];
+  uint8_t sensors_;
+  ResultCodes lastResult_;
+
+  ResultCodes readScratchpad(const Address address,
+                             gbj_ds18b20::Scratchpad scratchpad)
+  {
+    setLastResult();
+    reset();
+    select(address);
+    write(READ_SCRATCHPAD);
+    read_bytes(scratchpad, gbj_ds18b20::SCRATCHPAD_LEN);
+    if (scratchpad[CONFIG] == 0)
+    {
+      return setLastResult(gbj_ds18b20::ERROR_NO_DEVICE);
+    }
+    if (!gbj_ds18b20_crc::isValid(scratchpad, gbj_ds18b20::SCRATCHPAD_LEN))
+    {
+      return setLastResult(gbj_ds18b20::ERROR_CRC_SCRATCHPAD);
+    }
+    return getLastResult();
+  }
+
+  // Write bank resolution to the sensor only if it differs
+  ResultCodes configure(const Address address)
+  {
+    gbj_ds18b20::Scratchpad scratchpad;
+    if (isError(readScratchpad(address, scratchpad)) ||
+        scratchpad[CONFIG] == CONFIG_REG)
+    {
+      return getLastResult();
+    }
+    reset();
+    select(address);
+    write(WRITE_SCRATCHPAD);
+    write(scratchpad[ALARM_HIGH], isPowerParasite());
+    write(scratchpad[ALARM_LOW], isPowerParasite());
+    write(CONFIG_REG, isPowerParasite());
+    reset();
+    select(address);
+    write(COPY_SCRATCHPAD, isPowerParasite());
+    // Wait 10 ms in parasitic power mode according to datasheet
+    if (isPowerParasite())
+    {
+      delay(10);
+    }
+    return getLastResult();
+  }
+};
+
+#endif
@@ -0,0 +1,137 @@
+/*
+  NAME:
+  gbj_ds18b20_crc
+
+  DESCRIPTION:
+  Table driven CRC8 checksum of the one-wire bus (Dallas/Maxim polynomial
+  x^8 + x^5 + x^4 + 1) for sensor addresses and scratchpads.
+  - The 256 bytes lookup table is stored in flash memory (PROGMEM) on AVR.
+  - The checksum of a frame including its trailing CRC byte is zero for
+    a valid frame, so that validation needs no comparison with the last byte.
+  - Batch validation processes frames stored contiguously with fixed length
+    and computes checksums of four frames interleaved, so that independent
+    table lookups overlap in the processor pipeline.
+  - The module does not depend on the one-wire library, so that it can be
+    used on a host for validating forwarded raw frames.
+
+  LICENSE:
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the license GNU GPL v3
+  http://www.gnu.org/licenses/gpl-3.0.html (related to original code) and MIT
+  License (MIT) for added code.
+
+  CREDENTIALS:
+  Author: Libor Gabaj
+  GitHub: https://github.com/mrkaleArduinoLib/gbj_ds18b20.git
+ */
+#ifndef GBJ_DS18B20_CRC_H
+#define GBJ_DS18B20_CRC_H
+
+#if defined(__AVR__)
+  #include <Arduino.h>
+  #include <avr/pgmspace.h>
+  #include <inttypes.h>
+#elif defined(ESP8266) || defined(ESP32)
+  #include <Arduino.h>
+#else
+  #include <stddef.h>
+  #include <stdint.h>
+#endif
+
+class gbj_ds18b20_crc
+{
+public:
+  /*
+    Calculate checksum
+
+    DESCRIPTION:
+    The method calculates CRC8 checksum of the data buffer by lookup table.
+
+    PARAMETERS:
+    data - Pointer to the data buffer.
+      - Data type: array of non-negative integers
+      - Default value: none
+      - Limited range: system address range
+
+    len - Number of bytes in the data buffer.
+      - Data type: non-negative integer
+      - Default value: none
+      - Limited range: 0 ~ 255
+
+    RETURN: Checksum.
+  */
+  static uint8_t crc8(const uint8_t *data, uint8_t len);
+
+  /*
+    Validate frame
+
+    DESCRIPTION:
+    The method checks whether the last byte of the frame is the checksum
+    of preceding bytes.
+
+    PARAMETERS:
+    frame - Pointer to the frame, e.g., address or scratchpad.
+      - Data type: array of non-negative integers
+      - Default value: none
+      - Limited range: system address range
+
+    frameLen - Number of bytes in the frame including the checksum.
+      - Data type: non-negative integer
+      - Default value: none
+      - Limited range: 1 ~ 255
+
+    RETURN: Flag about valid frame.
+  */
+  static inline bool isValid(const uint8_t *frame, uint8_t frameLen)
+  {
+    return crc8(frame, frameLen) == 0;
+  }
+
+  /*
+    Validate batch of frames
+
+    DESCRIPTION:
+    The method validates frames of the same length stored contiguously
+    one after another, e.g., an array of addresses or scratchpads.
+
+    PARAMETERS:
+    frames - Pointer to the first frame.
+      - Data type: array of non-negative integers
+      - Default value: none
+      - Limited range: system address range
+
+    frameLen - Number of bytes in each frame including the checksum.
+      - Data type: non-negative integer
+      - Default value: none
+      - Limited range: 1 ~ 255
+
+    count - Number of frames.
+      - Data type: non-negative integer
+      - Default value: none
+      - Limited range: 0 ~ 65535
+
+    valid - Pointer to the array of flags about valid frame for each frame.
+      - Data type: array of booleans
+      - Default value: 0 (flags not needed)
+      - Limited range: system address range
+
+    RETURN: Number of valid frames.
+  */
+  static uint16_t validate(const uint8_t *frames,
+                           uint8_t frameLen,
+                           uint16_t count,
+                           bool *valid = 0);
+
+private:
+  static const uint8_t table_[256];
+  static inline uint8_t lookup(uint8_t index)
+  {
+#if defined(__AVR__)
+    return pgm_read_byte(&table_[index]);
+#else
+    return table_[index];
+#endif
+  }
+};
+
+#endif
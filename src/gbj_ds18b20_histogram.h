@@ -0,0 +1,150 @@
+/*
+  NAME:
+  gbj_ds18b20_histogram
+
+  DESCRIPTION:
+  Fixed-bucket histogram of measured conversion times of temperature sensors
+  Dallas Semiconductor DS18B20.
+  - The histogram covers the range from zero to the maximal conversion time
+    of a resolution according to datasheet by equal buckets. Longer times are
+    counted in the last bucket.
+  - When a bucket counter is about to overflow, all counters are halved,
+    so that the histogram keeps the shape with gradually aging samples.
+  - Percentiles are estimated by the upper limit of a bucket, so that they
+    never underestimate the measured time.
+
+  LICENSE:
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the license GNU GPL v3
+  http://www.gnu.org/licenses/gpl-3.0.html (related to original code) and MIT
+  License (MIT) for added code.
+
+  CREDENTIALS:
+  Author: Libor Gabaj
+  GitHub: https://github.com/mrkaleArduinoLib/gbj_ds18b20.git
+ */
+#ifndef GBJ_DS18B20_HISTOGRAM_H
+#define GBJ_DS18B20_HISTOGRAM_H
+
+#if defined(__AVR__)
+  #include <Arduino.h>
+  #include <inttypes.h>
+#elif defined(ESP8266) || defined(ESP32)
+  #include <Arduino.h>
+#else
+  #include <stdint.h>
+  #include <string.h>
+#endif
+
+class gbj_ds18b20_histogram
+{
+public:
+  enum Params : uint8_t
+  {
+    BUCKETS = 16,
+  };
+
+  /*
+    Constructor
+
+    DESCRIPTION:
+    Constructor creates the empty histogram for the range of times.
+
+    PARAMETERS:
+    rangeMillis - Maximal expected conversion time in milliseconds.
+      - Data type: non-negative integer
+      - Default value: 750
+      - Limited range: 16 ~ 65535
+
+    RETURN: object
+  */
+  gbj_ds18b20_histogram(uint16_t rangeMillis = 750) { begin(rangeMillis); }
+
+  // Clear histogram and set its range
+  inline void begin(uint16_t rangeMillis)
+  {
+    // Round up for covering whole range
+    width_ = (rangeMillis + Params::BUCKETS - 1) / Params::BUCKETS;
+    if (width_ == 0)
+    {
+      width_ = 1;
+    }
+    reset();
+  }
+  inline void reset()
+  {
+    memset(counts_, 0, sizeof(counts_));
+    samples_ = 0;
+  }
+
+  // Count conversion time in milliseconds
+  void record(uint32_t convMillis)
+  {
+    // Clamp before narrowing, so that very long times never wrap around
+    uint32_t bucket = convMillis / width_;
+    if (bucket >= Params::BUCKETS)
+    {
+      bucket = Params::BUCKETS - 1;
+    }
+    if (counts_[bucket] == 0xFFFF)
+    {
+      samples_ = 0;
+      for (uint8_t i = 0; i < Params::BUCKETS; i++)
+      {
+        counts_[i] /= 2;
+        samples_ += counts_[i];
+      }
+    }
+    counts_[bucket]++;
+    samples_++;
+  }
+
+  /*
+    Estimate percentile
+
+    DESCRIPTION:
+    The method returns the upper limit of the bucket, in which the percentile
+    of recorded times lies.
+
+    PARAMETERS:
+    percent - Percentile.
+      - Data type: non-negative integer
+      - Default value: 99
+      - Limited range: 1 ~ 100
+
+    RETURN: Conversion time in milliseconds or 0 for empty histogram.
+  */
+  uint16_t getPercentile(uint8_t percent = 99)
+  {
+    if (samples_ == 0)
+    {
+      return 0;
+    }
+    // Number of samples at or below the percentile rounded up
+    uint32_t rank = ((uint32_t)samples_ * percent + 99) / 100;
+    uint32_t cumulated = 0;
+    uint8_t bucket = 0;
+    for (; bucket < Params::BUCKETS - 1; bucket++)
+    {
+      cumulated += counts_[bucket];
+      if (cumulated >= rank)
+      {
+        break;
+      }
+    }
+    return (bucket + 1) * width_;
+  }
+
+  // Public getters
+  inline uint32_t getSamples() { return samples_; }
+  inline uint16_t getCount(uint8_t bucket) { return counts_[bucket]; }
+  inline uint16_t getBucketMillis() { return width_; }
+
+private:
+  uint16_t counts_[Params::BUCKETS];
+  uint32_t samples_;
+  // Bucket width in milliseconds
+  uint16_t width_;
+};
+
+#endif
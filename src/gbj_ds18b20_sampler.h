@@ -0,0 +1,299 @@
+/*
+  NAME:
+  gbj_ds18b20_sampler
+
+  DESCRIPTION:
+  Non-blocking scheduler of temperature sampling by sensors Dallas
+  Semiconductor DS18B20 with individual sampling periods and resolutions.
+  - Up to N sensors identified by their addresses are registered with their
+    own sampling period and resolution, which is written to a sensor only if
+    it differs from the current one.
+  - The method run() should be called repeatedly, e.g., in the function loop()
+    of a sketch. It never waits for a conversion.
+  - Sensors due at the same time are sampled either by one bulk conversion
+    (SKIP_ROM) or by individual conversions (MATCH_ROM) one after another,
+    whichever occupies the bus shorter. The bulk conversion lasts for the
+    highest resolution on the bus, while individual conversions last for
+    the sum of conversion times of due sensors.
+  - The scheduler keeps the period of every sensor without drifting. If it
+    falls behind more than one period, it skips missed samples.
+
+  LICENSE:
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the license GNU GPL v3
+  http://www.gnu.org/licenses/gpl-3.0.html (related to original code) and MIT
+  License (MIT) for added code.
+
+  CREDENTIALS:
+  Author: Libor Gabaj
+  GitHub: https://github.com/mrkaleArduinoLib/gbj_ds18b20.git
+ */
+#ifndef GBJ_DS18B20_SAMPLER_H
+#define GBJ_DS18B20_SAMPLER_H
+
+#include "gbj_ds18b20.h"
+
+template<uint8_t N>
+class gbj_ds18b20_sampler
+{
+  static_assert(N > 0, "Sampler should contain at least one sensor");
+
+public:
+  typedef gbj_ds18b20::ResultCodes ResultCodes;
+
+  /*
+    Constructor
+
+    DESCRIPTION:
+    Constructor creates the empty scheduler for the one-wire bus.
+    - The bus instance should not be used for other conversions while the
+      scheduler runs.
+
+    PARAMETERS:
+    ds - Instance of the one-wire bus with temperature sensors.
+      - Data type: gbj_ds18b20
+      - Default value: none
+      - Limited range: none
+
+    RETURN: object
+  */
+  explicit gbj_ds18b20_sampler(gbj_ds18b20 &ds)
+    : ds_(ds)
+    , sensors_(0)
+    , busy_(false)
+    , busMillis_(0)
+  {
+  }
+
+  /*
+    Register sensor
+
+    DESCRIPTION:
+    The method registers the sensor with its sampling period and resolution
+    and writes the resolution to the sensor if it differs. The first sample
+    of the sensor is due immediately. Sensors registered before the first
+    sample of the first sensor share its phase.
+    - If the resolution of the sensor is lowered, the highest resolution on
+      the bus is detected again, so that a bulk conversion is not costed
+      by the former one.
+
+    PARAMETERS:
+    address - Temperature sensor address.
+      - Data type: array of non-negative integers
+      - Default value: none
+      - Limited range: 0 ~ 255[8]
+
+    periodMillis - Sampling period in milliseconds.
+      - Data type: non-negative integer
+      - Default value: none
+      - Limited range: 1 ~ 2^32 - 1
+
+    resolutionBits - Resolution of the sensor in bits.
+      - Data type: non-negative integer
+      - Default value: 12
+      - Limited range: 9 ~ 12
+
+    RETURN: Result code. If there is no free slot for a sensor or the
+      scheduler waits for a conversion, the error code ERROR_NO_SENSOR is
+      returned and the sensor is not registered.
+  */
+  ResultCodes add(const gbj_ds18b20::Address address,
+                  uint32_t periodMillis,
+                  uint8_t resolutionBits = 12)
+  {
+    if (sensors_ >= N || busy_)
+    {
+      return gbj_ds18b20::ERROR_NO_SENSOR;
+    }
+    if (ds_.isError(ds_.readSensor(address)))
+    {
+      return ds_.getLastResult();
+    }
+    if (ds_.getResolutionBits() != resolutionBits)
+    {
+      bool lowered = ds_.getResolutionBits() > resolutionBits;
+      ds_.cacheResolutionBits(resolutionBits);
+      if (ds_.isError(ds_.setCache()))
+      {
+        return ds_.getLastResult();
+      }
+      // Writing raises the bus resolution only, detecting lowers it as well
+      if (lowered && (ds_.isError(ds_.devices()) ||
+                      ds_.isError(ds_.readSensor(address))))
+      {
+        return ds_.getLastResult();
+      }
+    }
+    // Join the first sensor waiting for its first sample, so that sensors
+    // registered together stay in phase despite the time of writing them
+    uint32_t now = millis();
+    if (sensors_ > 0 && (int32_t)(now - slots_[0].tsDue) >= 0)
+    {
+      now = slots_[0].tsDue;
+    }
+    Slot &slot = slots_[sensors_++];
+    memcpy(slot.address, address, gbj_ds18b20::ADDRESS_LEN);
+    slot.periodMillis = periodMillis;
+    slot.resolutionBits = ds_.getResolutionBits();
+    slot.tsDue = now;
+    slot.tsSample = 0;
+    slot.temperature = ds_.getTemperatureRaw();
+    slot.result = ds_.getLastResult();
+    slot.due = false;
+    return slot.result;
+  }
+
+  /*
+    Run the scheduler
+
+    DESCRIPTION:
+    The method starts a conversion for due sensors or reads sensors after
+    finishing recent conversion. It returns immediately in any case.
+
+    PARAMETERS: None
+
+    RETURN: Flag about new samples available.
+  */
+  bool run()
+  {
+    if (busy_)
+    {
+      return finish();
+    }
+    uint32_t now = millis();
+    uint8_t due = 0;
+    uint32_t matchMillis = 0;
+    for (uint8_t i = 0; i < sensors_; i++)
+    {
+      slots_[i].due = (int32_t)(now - slots_[i].tsDue) >= 0;
+      if (slots_[i].due)
+      {
+        due++;
+        matchMillis += getConvMillis(slots_[i].resolutionBits);
+      }
+    }
+    if (due == 0)
+    {
+      return false;
+    }
+    // Bulk conversion lasts for the highest resolution on the bus
+    skipRom_ = due > 1 && getConvMillis(0) <= matchMillis;
+    if (skipRom_)
+    {
+      ds_.conversionStart();
+    }
+    else
+    {
+      for (current_ = 0; !slots_[current_].due; current_++)
+        ;
+      ds_.conversionStart(slots_[current_].address,
+                          slots_[current_].resolutionBits);
+    }
+    if (ds_.isError())
+    {
+      finish();
+      return true;
+    }
+    tsConv_ = now;
+    busy_ = true;
+    return false;
+  }
+
+  // Public getters
+  inline uint8_t getSensors() { return sensors_; }
+  inline uint8_t *getAddressRef(uint8_t index)
+  {
+    return slots_[index].address;
+  }
+  inline int16_t getTemperatureRaw(uint8_t index)
+  {
+    return slots_[index].temperature;
+  }
+  inline float getTemperature(uint8_t index)
+  {
+    return gbj_ds18b20::calcTemperature(slots_[index].temperature);
+  }
+  inline ResultCodes getLastResult(uint8_t index)
+  {
+    return slots_[index].result;
+  }
+  // Timestamp of recent sample in milliseconds
+  inline uint32_t getTimestamp(uint8_t index)
+  {
+    return slots_[index].tsSample;
+  }
+  // Total time of the bus occupied by conversions in milliseconds
+  inline uint32_t getBusMillis() { return busMillis_; }
+  inline bool isBusy() { return busy_; }
+
+private:
+  struct Slot
+  {
+    gbj_ds18b20::Address address;
+    uint32_t periodMillis;
+    uint32_t tsDue;
+    uint32_t tsSample;
+    int16_t temperature;
+    uint8_t resolutionBits;
+    ResultCodes result;
+    // Sensor sampled in current conversion
+    bool due;
+  };
+
+  gbj_ds18b20 &ds_;
+  Slot slots_[N];
+  uint8_t sensors_;
+  uint8_t current_;
+  bool busy_;
+  bool skipRom_;
+  uint32_t tsConv_;
+  uint32_t busMillis_;
+
+  // Conversion time for resolution or for the bus at zero resolution
+  uint16_t getConvMillis(uint8_t resolutionBits)
+  {
+    return ds_.getConvWaitMillis(resolutionBits ? resolutionBits - 9
+                                                : ds_.getResolutionBus());
+  }
+
+  // Read sensors after conversion and schedule their next samples
+  bool finish()
+  {
+    if (ds_.isSuccess() && !ds_.isConversionDone())
+    {
+      return false;
+    }
+    uint32_t now = millis();
+    if (busy_)
+    {
+      busMillis_ += now - tsConv_;
+    }
+    busy_ = false;
+    ResultCodes convResult = ds_.getLastResult();
+    for (uint8_t i = 0; i < sensors_; i++)
+    {
+      Slot &slot = slots_[i];
+      if (!slot.due || (!skipRom_ && i != current_))
+      {
+        continue;
+      }
+      slot.due = false;
+      slot.result = convResult;
+      if (convResult == gbj_ds18b20::SUCCESS)
+      {
+        slot.result = ds_.readSensor(slot.address);
+        slot.temperature = ds_.getTemperatureRaw();
+      }
+      slot.tsSample = now;
+      slot.tsDue += slot.periodMillis;
+      // Skip missed samples
+      if ((int32_t)(now - slot.tsDue) >= 0)
+      {
+        slot.tsDue = now + slot.periodMillis;
+      }
+    }
+    return true;
+  }
+};
+
+#endif
@@ -0,0 +1,306 @@
+/*
+  NAME:
+  gbj_ds18b20_service
+
+  DESCRIPTION:
+  Thread-safe front end to the one-wire bus with temperature sensors
+  Dallas Semiconductor DS18B20 for multitasking platforms, e.g., ESP32.
+  - The service owns an instance of the class gbj_ds18b20 and the only worker
+    thread of the service communicates on the one-wire bus, so that tasks
+    never share the internal buffers of the instance.
+  - Tasks submit jobs to the request queue and receive results through
+    futures.
+  - The worker takes all pending jobs at once and merges consecutive
+    measurement jobs into one bulk conversion followed by reading individual
+    sensors.
+  - The header requires the C++ standard threading library, so that it is not
+    included by the main library header and it is not available on AVR.
+
+  LICENSE:
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the license GNU GPL v3
+  http://www.gnu.org/licenses/gpl-3.0.html (related to original code) and MIT
+  License (MIT) for added code.
+
+  CREDENTIALS:
+  Author: Libor Gabaj
+  GitHub: https://github.com/mrkaleArduinoLib/gbj_ds18b20.git
+ */
+#ifndef GBJ_DS18B20_SERVICE_H
+#define GBJ_DS18B20_SERVICE_H
+
+#include "gbj_ds18b20.h"
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+
+class gbj_ds18b20_service
+{
+public:
+  typedef gbj_ds18b20::ResultCodes ResultCodes;
+
+  // Result of a job for a sensor
+  struct Reading
+  {
+    ResultCodes result;
+    // Values below are zero for failed job
+    // Raw temperature in sixteenths of centigrade
+    int16_t temperature;
+    // Resolution in bits
+    uint8_t resolution;
+    int8_t alarmLow;
+    int8_t alarmHigh;
+  };
+
+  /*
+    Constructor
+
+    DESCRIPTION:
+    Constructor creates the service for the provided bus instance and starts
+    the worker thread.
+    - The bus instance must not be used directly while the service runs.
+
+    PARAMETERS:
+    ds - Instance of the one-wire bus with temperature sensors.
+      - Data type: gbj_ds18b20
+      - Default value: none
+      - Limited range: none
+
+    RETURN: object
+  */
+  explicit gbj_ds18b20_service(gbj_ds18b20 &ds)
+    : ds_(ds)
+    , running_(true)
+    , worker_(&gbj_ds18b20_service::run, this)
+  {
+  }
+
+  // Destructor finishes pending jobs and stops the worker thread
+  ~gbj_ds18b20_service()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      running_ = false;
+    }
+    wakeup_.notify_one();
+    worker_.join();
+  }
+
+  gbj_ds18b20_service(const gbj_ds18b20_service &) = delete;
+  gbj_ds18b20_service &operator=(const gbj_ds18b20_service &) = delete;
+
+  /*
+    Measure temperature by individual sensor
+
+    DESCRIPTION:
+    The method submits the job for temperature conversion and reading the
+    sensor with provided address. Measurement jobs pending at the same time
+    are served by one bulk conversion.
+
+    PARAMETERS:
+    address - Temperature sensor address.
+      - Data type: array of non-negative integers
+      - Default value: none
+      - Limited range: 0 ~ 255[8]
+
+    RETURN: Future with the reading of the sensor.
+  */
+  std::future<Reading> measure(const gbj_ds18b20::Address address)
+  {
+    return submit(Job::MEASURE, address);
+  }
+
+  /*
+    Read individual sensor
+
+    DESCRIPTION:
+    The method submits the job for reading the sensor with provided address
+    without initiating a conversion.
+
+    PARAMETERS:
+    address - Temperature sensor address.
+      - Data type: array of non-negative integers
+      - Default value: none
+      - Limited range: 0 ~ 255[8]
+
+    RETURN: Future with the reading of the sensor.
+  */
+  std::future<Reading> read(const gbj_ds18b20::Address address)
+  {
+    return submit(Job::READ, address);
+  }
+
+  /*
+    Configure individual sensor
+
+    DESCRIPTION:
+    The method submits the job for writing alarm temperatures and resolution
+    to the sensor with provided address.
+
+    PARAMETERS:
+    address - Temperature sensor address.
+      - Data type: array of non-negative integers
+      - Default value: none
+      - Limited range: 0 ~ 255[8]
+
+    alarmLow, alarmHigh - Alarm temperatures in centigrades.
+      - Data type: integer
+      - Default value: none
+      - Limited range: -55 ~ 125
+
+    resolution - Resolution in bits.
+      - Data type: non-negative integer
+      - Default value: none
+      - Limited range: 9 ~ 12
+
+    RETURN: Future with the reading of the sensor after configuration.
+  */
+  std::future<Reading> configure(const gbj_ds18b20::Address address,
+                                 int8_t alarmLow,
+                                 int8_t alarmHigh,
+                                 uint8_t resolution)
+  {
+    return submit(Job::CONFIGURE, address, alarmLow, alarmHigh, resolution);
+  }
+
+  // Public getters
+  inline size_t getPending()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+  }
+
+private:
+  struct Job
+  {
+    enum Types : uint8_t
+    {
+      MEASURE,
+      READ,
+      CONFIGURE,
+    } type;
+    gbj_ds18b20::Address address;
+    int8_t alarmLow;
+    int8_t alarmHigh;
+    uint8_t resolution;
+    std::promise<Reading> reading;
+  };
+
+  gbj_ds18b20 &ds_;
+  std::mutex mutex_;
+  std::condition_variable wakeup_;
+  std::deque<Job> queue_;
+  bool running_;
+  // Constructed last, after all members used by the worker
+  std::thread worker_;
+
+  // Add job to the queue and wake up the worker
+  std::future<Reading> submit(Job::Types type,
+                              const gbj_ds18b20::Address address,
+                              int8_t alarmLow = 0,
+                              int8_t alarmHigh = 0,
+                              uint8_t resolution = 0)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.emplace_back();
+    Job &job = queue_.back();
+    job.type = type;
+    memcpy(job.address, address, gbj_ds18b20::ADDRESS_LEN);
+    job.alarmLow = alarmLow;
+    job.alarmHigh = alarmHigh;
+    job.resolution = resolution;
+    std::future<Reading> future = job.reading.get_future();
+    wakeup_.notify_one();
+    return future;
+  }
+
+  // Reading of the sensor cached in the bus instance, zeroed at failure
+  Reading reading(ResultCodes result)
+  {
+    Reading value = {};
+    value.result = result;
+    if (result != gbj_ds18b20::SUCCESS)
+    {
+      return value;
+    }
+    value.temperature = ds_.getTemperatureRaw();
+    value.resolution = ds_.getResolutionBits();
+    value.alarmLow = ds_.getAlarmLow();
+    value.alarmHigh = ds_.getAlarmHigh();
+    return value;
+  }
+
+  // Serve consecutive measurement jobs by one conversion
+  void measureBatch(std::deque<Job> &batch)
+  {
+    if (batch.size() == 1)
+    {
+      Job &job = batch.front();
+      job.reading.set_value(reading(ds_.measureTemperature(job.address)));
+      return;
+    }
+    ResultCodes result = ds_.conversion();
+    for (Job &job : batch)
+    {
+      job.reading.set_value(reading(result == gbj_ds18b20::SUCCESS
+                                      ? ds_.readSensor(job.address)
+                                      : result));
+    }
+  }
+
+  void serve(Job &job)
+  {
+    ResultCodes result = ds_.readSensor(job.address);
+    if (job.type == Job::CONFIGURE && result == gbj_ds18b20::SUCCESS)
+    {
+      ds_.cacheAlarmLow(job.alarmLow);
+      ds_.cacheAlarmHigh(job.alarmHigh);
+      ds_.cacheResolutionBits(job.resolution);
+      result = ds_.setCache();
+    }
+    job.reading.set_value(reading(result));
+  }
+
+  // Worker thread owning the bus
+  void run()
+  {
+    std::deque<Job> jobs, batch;
+    for (;;)
+    {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wakeup_.wait(lock, [this] { return !running_ || !queue_.empty(); });
+        if (queue_.empty())
+        {
+          return;
+        }
+        jobs.swap(queue_);
+      }
+      while (!jobs.empty())
+      {
+        if (jobs.front().type == Job::MEASURE)
+        {
+          batch.push_back(std::move(jobs.front()));
+          jobs.pop_front();
+          continue;
+        }
+        if (!batch.empty())
+        {
+          measureBatch(batch);
+          batch.clear();
+        }
+        serve(jobs.front());
+        jobs.pop_front();
+      }
+      if (!batch.empty())
+      {
+        measureBatch(batch);
+        batch.clear();
+      }
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,226 @@
+#include "gbj_ds18b20_trace.h"
+
+namespace
+{
+const uint8_t SIGNATURE[] = { 'D', 'S', 'T', gbj_ds18b20_trace::VERSION };
+const uint8_t OP_MASK = 0x0F;
+const uint8_t FLAGS_MASK = 0x70;
+const uint8_t PAYLOAD_FLAG = 0x80;
+}
+
+void gbj_ds18b20_trace::record(uint8_t *buffer, uint16_t capacity)
+{
+  buffer_ = buffer;
+  capacity_ = capacity;
+  length_ = position_ = 0;
+  micros_ = transactions_ = 0;
+  lastHeader_ = 0;
+  repeats_ = 0;
+  overflow_ = diverged_ = false;
+  mode_ = Modes::MODE_RECORD;
+  for (uint8_t i = 0; i < Params::SIGNATURE_LEN; i++)
+  {
+    putByte(SIGNATURE[i]);
+  }
+  tsLast_ = micros();
+}
+
+bool gbj_ds18b20_trace::replay(const uint8_t *trace,
+                               uint16_t length,
+                               ClockHook *clockHook)
+{
+  trace_ = trace;
+  length_ = length;
+  position_ = 0;
+  micros_ = transactions_ = 0;
+  lastHeader_ = 0;
+  repeats_ = 0;
+  clockHook_ = clockHook;
+  overflow_ = diverged_ = false;
+  mode_ = Modes::MODE_OFF;
+  if (length_ < Params::SIGNATURE_LEN ||
+      memcmp(trace_, SIGNATURE, Params::SIGNATURE_LEN) != 0)
+  {
+    diverged_ = true;
+    return false;
+  }
+  position_ = Params::SIGNATURE_LEN;
+  mode_ = Modes::MODE_REPLAY;
+  return true;
+}
+
+void gbj_ds18b20_trace::stop()
+{
+  if (isRecording())
+  {
+    putRepeats();
+  }
+  mode_ = Modes::MODE_OFF;
+}
+
+bool gbj_ds18b20_trace::putByte(uint8_t data)
+{
+  if (length_ >= capacity_)
+  {
+    overflow_ = true;
+    mode_ = Modes::MODE_OFF;
+    return false;
+  }
+  buffer_[length_++] = data;
+  return true;
+}
+
+void gbj_ds18b20_trace::putVarint(uint32_t value)
+{
+  do
+  {
+    uint8_t part = value & 0x7F;
+    value >>= 7;
+    putByte(value ? part | 0x80 : part);
+  } while (value);
+}
+
+void gbj_ds18b20_trace::putRepeats()
+{
+  if (repeats_ == 0)
+  {
+    return;
+  }
+  putByte(Operations::OP_REPEAT | PAYLOAD_FLAG);
+  putVarint(repeatMicros_);
+  putByte(2);
+  putByte(repeats_ & 0xFF);
+  putByte(repeats_ >> 8);
+  repeats_ = 0;
+}
+
+void gbj_ds18b20_trace::put(Operations op,
+                            uint8_t flags,
+                            const uint8_t *data,
+                            uint8_t len)
+{
+  if (!isRecording())
+  {
+    return;
+  }
+  uint32_t tsNow = micros();
+  uint32_t delta = tsNow - tsLast_;
+  tsLast_ = tsNow;
+  micros_ += delta;
+  transactions_++;
+  uint8_t header = op | ((flags << 4) & FLAGS_MASK) | (len ? PAYLOAD_FLAG : 0);
+  if (len == 0 && header == lastHeader_ && repeats_ < 0xFFFF)
+  {
+    if (repeats_ == 0)
+    {
+      repeatMicros_ = 0;
+    }
+    repeats_++;
+    repeatMicros_ += delta;
+    return;
+  }
+  putRepeats();
+  lastHeader_ = header;
+  putByte(header);
+  putVarint(delta);
+  if (len)
+  {
+    putByte(len);
+    for (uint8_t i = 0; i < len; i++)
+    {
+      putByte(data[i]);
+    }
+  }
+}
+
+uint32_t gbj_ds18b20_trace::getVarint()
+{
+  uint32_t value = 0;
+  uint8_t shift = 0;
+  uint8_t part;
+  do
+  {
+    part = getByte();
+    value |= (uint32_t)(part & 0x7F) << shift;
+    shift += 7;
+  } while ((part & 0x80) && shift < 32);
+  return value;
+}
+
+bool gbj_ds18b20_trace::get(Operations op,
+                            uint8_t &flags,
+                            uint8_t *data,
+                            uint8_t len)
+{
+  flags = 0;
+  if (!isReplaying())
+  {
+    return false;
+  }
+  // Start repetitions of the previous transaction
+  if (repeats_ == 0 && !isEnd() &&
+      (trace_[position_] & OP_MASK) == Operations::OP_REPEAT)
+  {
+    getByte();
+    repeatMicros_ = getVarint();
+    getByte();
+    repeats_ = getByte();
+    repeats_ |= getByte() << 8;
+  }
+  uint32_t delta;
+  uint8_t header;
+  if (repeats_)
+  {
+    header = lastHeader_;
+    // Last repetition takes the rest of total time
+    delta = repeats_ > 1 ? repeatMicros_ / repeats_ : repeatMicros_;
+    repeatMicros_ -= delta;
+    repeats_--;
+    if ((header & OP_MASK) != op)
+    {
+      diverge();
+      return false;
+    }
+  }
+  else
+  {
+    if (isEnd())
+    {
+      stop();
+      return false;
+    }
+    if ((trace_[position_] & OP_MASK) != op)
+    {
+      diverge();
+      return false;
+    }
+    header = lastHeader_ = getByte();
+    delta = getVarint();
+  }
+  flags = (header & FLAGS_MASK) >> 4;
+  micros_ += delta;
+  transactions_++;
+  payloadLen_ = 0;
+  if (header & PAYLOAD_FLAG)
+  {
+    payloadLen_ = getByte();
+    if (payloadLen_ > len)
+    {
+      diverge();
+      return false;
+    }
+    for (uint8_t i = 0; i < payloadLen_; i++)
+    {
+      data[i] = getByte();
+    }
+  }
+  if (len > payloadLen_)
+  {
+    memset(data + payloadLen_, 0, len - payloadLen_);
+  }
+  if (clockHook_)
+  {
+    clockHook_(micros_);
+  }
+  return true;
+}
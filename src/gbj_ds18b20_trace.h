@@ -0,0 +1,198 @@
+/*
+  NAME:
+  gbj_ds18b20_trace
+
+  DESCRIPTION:
+  Compact binary trace of one-wire bus transactions of the library
+  gbj_ds18b20 for recording in the field and deterministic replaying.
+  - The library records or replays transactions, if its source is compiled
+    with the macro GBJ_DS18B20_TRACE as a global build flag and an instance
+    of this class is attached.
+  - The trace is stored in a buffer provided by a sketch, so that it can be
+    dumped, e.g., to a serial line or a file system, and replayed on a host.
+  - Each transaction is stored as a header byte with the operation code in
+    lower nibble, operation flags in bits 4 ~ 6, and payload presence in
+    bit 7, followed by time delta from previous transaction in microseconds
+    as a variable length integer (7 bits per byte, least significant first)
+    and optional payload with its length in the first byte.
+  - Repeated transactions with the same flags and no payload, typically
+    polling the end of a conversion, are stored as one transaction with
+    the number of repetitions in its payload and total time of them.
+  - The trace starts with the signature "DST" and format version.
+  - At replaying the transactions are taken from the trace instead of the
+    bus and the time of the trace is reported by an optional clock hook,
+    so that a host can provide recorded time to the library.
+  - If replayed transaction does not match the recorded one, the replaying
+    stops and the trace is marked as diverged.
+
+  LICENSE:
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the license GNU GPL v3
+  http://www.gnu.org/licenses/gpl-3.0.html (related to original code) and MIT
+  License (MIT) for added code.
+
+  CREDENTIALS:
+  Author: Libor Gabaj
+  GitHub: https://github.com/mrkaleArduinoLib/gbj_ds18b20.git
+ */
+#ifndef GBJ_DS18B20_TRACE_H
+#define GBJ_DS18B20_TRACE_H
+
+// Time source is needed on all platforms, on a host provided by a shim
+#if defined(PARTICLE)
+  #include <Particle.h>
+#else
+  #include <Arduino.h>
+#endif
+#if defined(__AVR__)
+  #include <inttypes.h>
+#endif
+
+class gbj_ds18b20_trace
+{
+public:
+  enum Operations : uint8_t
+  {
+    OP_RESET = 1,
+    OP_SELECT,
+    OP_SKIP,
+    OP_WRITE,
+    OP_READ_BYTES,
+    OP_READ_BIT,
+    OP_SEARCH,
+    OP_RESET_SEARCH,
+    // Repetition of the previous transaction
+    OP_REPEAT,
+  };
+
+  enum Modes : uint8_t
+  {
+    MODE_OFF,
+    MODE_RECORD,
+    MODE_REPLAY,
+  };
+
+  enum Params : uint8_t
+  {
+    VERSION = 1,
+    SIGNATURE_LEN = 4,
+  };
+
+  typedef void ClockHook(uint32_t micros);
+
+  /*
+    Start recording
+
+    DESCRIPTION:
+    The method starts recording transactions to the provided buffer from its
+    beginning. If the buffer gets full, recording stops and the trace is
+    marked as overflowed.
+
+    PARAMETERS:
+    buffer - Pointer to the buffer for the trace.
+      - Data type: array of non-negative integers
+      - Default value: none
+      - Limited range: system address range
+
+    capacity - Size of the buffer in bytes.
+      - Data type: non-negative integer
+      - Default value: none
+      - Limited range: 4 ~ 65535
+
+    RETURN: none
+  */
+  void record(uint8_t *buffer, uint16_t capacity);
+
+  /*
+    Start replaying
+
+    DESCRIPTION:
+    The method starts replaying transactions from the provided trace.
+
+    PARAMETERS:
+    trace - Pointer to the recorded trace.
+      - Data type: array of non-negative integers
+      - Default value: none
+      - Limited range: system address range
+
+    length - Length of the trace in bytes.
+      - Data type: non-negative integer
+      - Default value: none
+      - Limited range: 0 ~ 65535
+
+    clockHook - Procedure called with the time of the trace in microseconds
+      at every replayed transaction.
+      - Data type: ClockHook
+      - Default value: 0
+      - Limited range: system address range
+
+    RETURN: Flag about valid signature of the trace.
+  */
+  bool replay(const uint8_t *trace,
+              uint16_t length,
+              ClockHook *clockHook = 0);
+
+  // Stop recording or replaying, flushing pending repetitions
+  void stop();
+  // Stop replaying due to replayed transaction not matching the trace
+  inline void diverge()
+  {
+    diverged_ = true;
+    stop();
+  }
+
+  // Store transaction with optional payload, repetitions are pending
+  // until another transaction or stopping
+  void put(Operations op,
+           uint8_t flags = 0,
+           const uint8_t *data = 0,
+           uint8_t len = 0);
+
+  // Take transaction and its payload up to the length of the data buffer,
+  // false at mismatch or end of trace
+  bool get(Operations op,
+           uint8_t &flags,
+           uint8_t *data = 0,
+           uint8_t len = 0);
+
+  // Public getters
+  inline bool isRecording() { return mode_ == Modes::MODE_RECORD; }
+  inline bool isReplaying() { return mode_ == Modes::MODE_REPLAY; }
+  inline bool isOverflow() { return overflow_; }
+  inline bool isDiverged() { return diverged_; }
+  inline bool isEnd() { return position_ >= length_; }
+  inline uint16_t getLength() { return length_; }
+  inline uint16_t getPosition() { return position_; }
+  inline uint32_t getMicros() { return micros_; }
+  inline uint32_t getTransactions() { return transactions_; }
+  // Payload length of recently replayed transaction
+  inline uint8_t getPayloadLen() { return payloadLen_; }
+
+private:
+  uint8_t *buffer_ = 0;
+  const uint8_t *trace_ = 0;
+  uint16_t capacity_ = 0;
+  uint16_t length_ = 0;
+  uint16_t position_ = 0;
+  // Time of recent transaction since the start of trace
+  uint32_t micros_ = 0;
+  uint32_t tsLast_ = 0;
+  uint32_t transactions_ = 0;
+  uint8_t payloadLen_ = 0;
+  // Previous transaction and its repetitions
+  uint8_t lastHeader_ = 0;
+  uint16_t repeats_ = 0;
+  uint32_t repeatMicros_ = 0;
+  ClockHook *clockHook_ = 0;
+  Modes mode_ = Modes::MODE_OFF;
+  bool overflow_ = false;
+  bool diverged_ = false;
+
+  bool putByte(uint8_t data);
+  void putVarint(uint32_t value);
+  void putRepeats();
+  uint32_t getVarint();
+  inline uint8_t getByte() { return isEnd() ? 0 : trace_[position_++]; }
+};
+
+#endif